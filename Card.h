@@ -1,55 +1,159 @@
-
-/**
-* @file card.h
-* @brief Defines Suit, Rank, and Card structures for use with the CardDeck ADT.
-*
-* This header provides the fundamental data types representing a single
-* playing card. It is used by all modules that manipulate cards.
-*/
-#ifndef CARD_H
-#define CARD_H
-
-
-/**
-* @enum Suit
-* @brief Represents the four suits in a standard deck.
-*/
-typedef enum {
-	CLUB = 0, //Clubs suit 
-	SPADE, // Spades suit 
-	HEART, //Hearts suit 
-	DIAMOND //Diamonds suit 
-} Suit;
-
-
-/**
-* @enum Rank
-* @brief Represents card ranks from Two to Ace.
-*/
-typedef enum {
-	TWO = 2, //Rank 2
-	FOUR, // Rank 4
-	FIVE, // Rank 5
-	SIX, // Rank 6
-	SEVEN, // Rank 7
-	EIGHT, // Rank 8
-	NINE, // Rank 9
-	TEN, // Rank 10
-	JACK, // Jack
-	QUEEN, // Queen
-	KING, // King
-	ACE // Ace
-} Rank;
-
-
-/**
-* @struct Card
-* @brief Represents a single playing card with suit and rank.
-*/
-typedef struct {
-	Suit suit; // Suit of the card
-	Rank rank; // Rank of the card
-} Card;
-
-
-#endif 
\ No newline at end of file
+
+/**
+* @file card.h
+* @brief Defines Suit, Rank, and Card structures for use with the CardDeck ADT.
+*
+* This header provides the fundamental data types representing a single
+* playing card. It is used by all modules that manipulate cards.
+*/
+#ifndef CARD_H
+#define CARD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+/**
+* @enum Suit
+* @brief Represents the four suits in a standard deck.
+*/
+typedef enum {
+	CLUB = 0, //Clubs suit 
+	SPADE, // Spades suit 
+	HEART, //Hearts suit 
+	DIAMOND //Diamonds suit 
+} Suit;
+
+
+/**
+* @enum Rank
+* @brief Represents card ranks from Two to Ace.
+*/
+typedef enum {
+	TWO = 2, //Rank 2
+	THREE, // Rank 3
+	FOUR, // Rank 4
+	FIVE, // Rank 5
+	SIX, // Rank 6
+	SEVEN, // Rank 7
+	EIGHT, // Rank 8
+	NINE, // Rank 9
+	TEN, // Rank 10
+	JACK, // Jack
+	QUEEN, // Queen
+	KING, // King
+	ACE // Ace
+} Rank;
+
+
+/**
+* @struct Card
+* @brief Represents a single playing card packed into one byte.
+*
+* Bits 4-5 hold the suit and bits 0-3 hold the rank, so comparing the raw
+* byte orders cards by suit then rank (the card_compare() order).
+* Use card_suit() and card_rank() rather than reading the bits directly.
+*/
+typedef struct {
+	uint8_t bits; // (suit << CARD_SUIT_SHIFT) | rank
+} Card;
+
+#define CARD_SUIT_SHIFT 4 // Position of the suit bits
+#define CARD_RANK_MASK 0x0F // Mask selecting the rank bits
+#define CARD_SUIT_MASK 0x30 // Mask selecting the suit bits
+#define CARD_KEYS 64 // Distinct values of the packed byte; covers every card
+#define CARD_STRING_MAX 24 // Buffer size that holds any card_format() result
+
+
+/**
+* @brief Get the suit of a packed card.
+*/
+static inline Suit card_suit(Card c)
+{
+	return (Suit)(c.bits >> CARD_SUIT_SHIFT);
+}
+
+
+/**
+* @brief Get the rank of a packed card.
+*/
+static inline Rank card_rank(Card c)
+{
+	return (Rank)(c.bits & CARD_RANK_MASK);
+}
+
+
+/**
+* @brief Create a card from a suit and a rank.
+*/
+Card card_create(Suit suit, Rank rank);
+
+
+/**
+* @brief Format a card as "Suit-Rank" into a caller buffer. Thread-safe.
+* @param buf Destination; always NUL-terminated when size > 0.
+* @param size Size of buf; CARD_STRING_MAX always suffices.
+* @return Length of the full string, not counting the terminator.
+*/
+size_t card_format(Card c, char* buf, size_t size);
+
+
+/**
+* @brief Format a card as "Suit-Rank". Uses a static buffer overwritten on each call.
+*/
+const char* card_to_string(Card c);
+
+
+/**
+* @brief Print a card to stdout, followed by a newline if requested.
+*/
+void card_print(Card c, int newline);
+
+
+/**
+* @brief Render cards as "Suit-Rank" lines into one buffer.
+* @param buf Destination (not NUL-terminated), or NULL to only measure.
+* @param size Size of buf; only whole lines that fit are written.
+* @return Bytes needed for all the lines.
+*/
+size_t deck_format(const Card* cards, int64_t count, char* buf, size_t size);
+
+
+/**
+* @brief Write cards as "Suit-Rank" lines with a single fwrite.
+* @return 0 on success, -1 on allocation or write failure.
+*/
+int deck_write(const Card* cards, int64_t count, FILE* out);
+
+
+/**
+* @brief Return 1 if the cards share a suit or a rank, 0 otherwise.
+*/
+int card_matches(Card a, Card b);
+
+
+/**
+* @brief Compare two cards for ordering (suit then rank).
+* @return Negative, zero or positive like strcmp.
+*/
+int card_compare(const Card* a, const Card* b);
+
+
+/**
+* @brief Sort an array of cards into card_compare() order in linear time.
+*
+* Counting sort over the packed byte: one pass to histogram, one to write
+* the cards back. Equal cards are identical bytes, so the result is the
+* same as any stable sort.
+*/
+void card_sort(Card* cards, int64_t count);
+
+
+/**
+* @brief Sort an array of cards into reverse card_compare() order in linear time.
+*/
+void card_sort_desc(Card* cards, int64_t count);
+
+
+#endif
\ No newline at end of file
@@ -1,101 +1,218 @@
-#ifndef CARDDECK_H
-#define CARDDECK_H
-
-
-#include "card.h"
-
-
-/**
-* @struct CardNode
-* @brief A node in the singly-linked list representing a deck.
-*/
-typedef struct CardNode {
-	Card card; //Card stored in this node
-	struct CardNode* next; //Pointer to next node
-} CardNode;
-
-
-/**
-* @struct CardDeck
-* @brief Dynamic deck implemented as a singly-linked list.
-*/
-typedef struct {
-	CardNode* head; //Pointer to first card in the deck
-	int size; //Number of cards in the deck
-} CardDeck;
-
-
-/**
-* @brief Initialize an empty deck.
-* @param deck Pointer to deck.
-*/
-void initCardDeck(CardDeck* deck);
-
-
-/**
-* @brief Create a deck containing the specified number of standard packs.
-* @param deck Pointer to deck.
-* @param packs Number of packs (52 cards each).
-*/
-void createCardDeck(CardDeck * deck, int packs);
-/**
- * @brief Free all memory used by the deck.
- * @param deck Pointer to deck. 
- */ 
-
-void freeCardDeck(CardDeck* deck);
-
-/**
-* @brief Add a card to the top of the deck.
-* @param deck Pointer to deck.
-* @param c Card to add.
-*/
-void addCardTop(CardDeck* deck, Card c);
-
-
-/**
-* @brief Add a card to the bottom of the deck.
-* @param deck Pointer to deck.
-* @param c Card to add.
-*/
-void addCardBottom(CardDeck* deck, Card c);
-
-
-/**
-* @brief Remove the top card from the deck.
-* @param deck Pointer to deck.
-* @param out Pointer where removed card will be stored.
-* @return 1 if removed, 0 if deck empty.
-*/
-int removeTopCard(CardDeck* deck, Card* out);
-
-
-/**
-* @brief Remove card at specified index.
-* @param deck Pointer to deck.
-* @param index 0-based index.
-* @param out Pointer to store removed card.
-* @return 1 if removed, 0 otherwise.
-*/
-int removeCardAt(CardDeck* deck, int index, Card* out);
-
-
-/**
-* @brief Return number of cards in deck.
-*/
-int deckSize(const CardDeck* deck);
-
-
-/**
-* @brief Returns 1 if deck empty, 0 otherwise.
-*/
-int isDeckEmpty(const CardDeck* deck);
-
-
-/**
-* @brief Convert deck to array. Caller must free returned array.
-* @param deck Pointer to deck.
-* @return Array of Cards.
-*/
-Card* deckToArray(const CardDeck* deck);
+#ifndef CARDDECK_H
+#define CARDDECK_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Card.h"
+#include "rng.h"
+
+
+/*
+* Two layouts implement the functions below. By default a deck is a
+* singly-linked list in a slab arena (carddeck.c); building with
+* CARDDECK_RING defined makes it a contiguous ring buffer instead
+* (carddeckRing.c). Exactly one of the two sources is compiled in.
+*/
+#if defined(CARDDECK_RING)
+
+/**
+* @struct CardDeck
+* @brief Dynamic deck implemented as a ring-buffer deque.
+*
+* Card i from the top lives at cards[(head + i) & (capacity - 1)], so both
+* ends grow and shrink in O(1) and the cards stay in one block of memory.
+*/
+typedef struct {
+	Card* cards; //Ring storage, capacity is zero or a power of two
+	int64_t head; //Slot of the top card
+	int64_t size; //Number of cards in the deck
+	int64_t capacity; //Slots in cards
+} CardDeck;
+
+#else
+
+/**
+* @brief Index of a node in its deck's arena. Half the size of a pointer,
+*        which caps a list deck at CARDNODE_NIL - 1 cards (about 82M packs).
+*/
+typedef uint32_t CardNodeId;
+
+#define CARDNODE_NIL UINT32_MAX // Index meaning "no node"
+#define CARDNODE_CHUNK_SHIFT 8 // log2 of nodes per arena chunk
+#define CARDNODE_CHUNK_SIZE (1u << CARDNODE_CHUNK_SHIFT) // Nodes per arena chunk
+
+
+/**
+* @struct CardNode
+* @brief A node in the singly-linked list representing a deck.
+*/
+typedef struct CardNode {
+	Card card; //Card stored in this node
+	CardNodeId next; //Index of next node, or CARDNODE_NIL
+} CardNode;
+
+
+/**
+* @struct CardNodeArena
+* @brief Slab store for a deck's nodes.
+*
+* Nodes are carved out of fixed-size contiguous chunks and addressed by
+* index; removed nodes go on a free list and are reused before a new chunk
+* is allocated. The whole arena is released at once by freeCardDeck().
+*/
+typedef struct {
+	CardNode** chunks; //Array of chunk pointers
+	uint32_t chunkCount; //Chunks allocated
+	uint32_t chunkCapacity; //Length of the chunks array
+	uint32_t used; //Nodes ever handed out (high-water mark)
+	CardNodeId freeList; //First recycled node, or CARDNODE_NIL
+} CardNodeArena;
+
+
+/**
+* @struct CardDeck
+* @brief Dynamic deck implemented as a singly-linked list.
+*/
+typedef struct {
+	CardNodeId head; //Index of first card in the deck
+	int64_t size; //Number of cards in the deck
+	CardNodeArena arena; //Storage for this deck's nodes
+} CardDeck;
+
+#endif
+
+
+/**
+* @brief Initialize an empty deck.
+* @param deck Pointer to deck.
+*/
+void initCardDeck(CardDeck* deck);
+
+
+/**
+* @brief Create a deck containing the specified number of standard packs.
+* @param deck Pointer to deck.
+* @param packs Number of packs (52 cards each).
+*/
+void createCardDeck(CardDeck * deck, int64_t packs);
+/**
+ * @brief Free all memory used by the deck.
+ * @param deck Pointer to deck. 
+ */ 
+
+void freeCardDeck(CardDeck* deck);
+
+/**
+* @brief Add a card to the top of the deck.
+* @param deck Pointer to deck.
+* @param c Card to add.
+*/
+void addCardTop(CardDeck* deck, Card c);
+
+
+/**
+* @brief Add a card to the bottom of the deck.
+* @param deck Pointer to deck.
+* @param c Card to add.
+*/
+void addCardBottom(CardDeck* deck, Card c);
+
+
+/**
+* @brief Remove the top card from the deck.
+* @param deck Pointer to deck.
+* @param out Pointer where removed card will be stored.
+* @return 1 if removed, 0 if deck empty.
+*/
+int removeTopCard(CardDeck* deck, Card* out);
+
+
+/**
+* @brief Remove card at specified index.
+* @param deck Pointer to deck.
+* @param index 0-based index.
+* @param out Pointer to store removed card.
+* @return 1 if removed, 0 otherwise.
+*/
+int removeCardAt(CardDeck* deck, int64_t index, Card* out);
+
+
+/**
+* @brief Deal perPlayer cards to each of players hands in one pass.
+* @details Removes players * perPlayer cards from the top. Player p's cards
+*          land in out[p * perPlayer .. (p + 1) * perPlayer - 1].
+* @param deck Pointer to deck.
+* @param players Number of hands.
+* @param perPlayer Cards per hand.
+* @param roundRobin 1 to deal one card per player in turn, 0 to deal each
+*                   player a consecutive block.
+* @param out Array of at least players * perPlayer cards.
+* @return 1 if dealt, 0 if the deck holds too few cards (nothing removed).
+*/
+int dealCards(CardDeck* deck, int players, int perPlayer, int roundRobin, Card* out);
+
+
+/**
+* @brief Move every card below the top keep cards of src to the bottom of dst.
+* @details When dst is empty the two decks trade storage and only the kept
+*          cards are copied back, so the cost is O(keep) whatever the size.
+* @param src Deck to take cards from; left holding its top keep cards.
+* @param keep Cards to leave on src.
+* @param dst Deck to receive the cards, below any it already holds.
+*/
+void spliceCards(CardDeck* src, int64_t keep, CardDeck* dst);
+
+
+/**
+* @brief Sort the deck into card_compare() order, top card lowest.
+* @details Counting sort: one pass to histogram, one to rewrite the cards.
+* @param deck Pointer to deck.
+*/
+void sortCardDeck(CardDeck* deck);
+
+
+/**
+* @brief Shuffle the deck uniformly (Fisher-Yates).
+* @param deck Pointer to deck.
+* @param rng Generator to draw from; seed it for a repeatable shuffle.
+*/
+void shuffleCardDeck(CardDeck* deck, Rng* rng);
+
+
+/**
+* @brief Look at the top card without removing it.
+* @param deck Pointer to deck.
+* @param out Pointer where the top card will be stored.
+* @return 1 if the deck has a top card, 0 if empty.
+*/
+int peekTopCard(const CardDeck* deck, Card* out);
+
+
+/**
+* @brief Return number of cards in deck.
+*/
+int64_t deckSize(const CardDeck* deck);
+
+
+/**
+* @brief Returns 1 if deck empty, 0 otherwise.
+*/
+int isDeckEmpty(const CardDeck* deck);
+
+
+/**
+* @brief Convert deck to array. Caller must free returned array.
+* @param deck Pointer to deck.
+* @return Array of Cards.
+*/
+Card* deckToArray(const CardDeck* deck);
+
+
+/**
+* @brief Bytes of heap memory held by the deck's storage.
+* @param deck Pointer to deck.
+* @return Node arena (chunks plus chunk table) or ring buffer size, in bytes.
+*/
+size_t deckMemoryUsage(const CardDeck* deck);
 #endif
\ No newline at end of file
@@ -0,0 +1,484 @@
+/**
+ * @file bench.c
+ * @brief Microbenchmarks for the deck backends and the game loop.
+ *
+ * The deck backend is the one deck.h selects, so build this file once per
+ * backend with the matching deck source:
+ *   array (cardDeck.c):           default
+ *   linked list (carddeck.c):     -DDECK_BACKEND_LIST
+ *   ring buffer (carddeckRing.c): -DDECK_BACKEND_LIST -DCARDDECK_RING
+ *
+ * Usage:
+ *   bench [--max-packs N] [--budget SECONDS]   run, CSV on stdout
+ *   bench --compare OLD.csv NEW.csv [--threshold PCT]
+ *
+ * Each CSV row is one (backend, op, packs) measurement: ns per operation,
+ * heap bytes and allocation calls per operation. Allocation counts need
+ * glibc (malloc is wrapped); elsewhere they are reported as -1. Compare
+ * mode lists every row whose ns/op grew by more than the threshold and
+ * exits with status 1 if there was any.
+ *
+ * batch plays whole games BATCH_DEFAULT_LANES at a time through a GameBatch,
+ * so its ns/op is per game like the game row's; it also stops at
+ * BATCH_MAX_PACKS packs.
+ *
+ * state_step clones a GameState and applies and undoes one move; it stops
+ * at GAMESTATE_MAX_PACKS packs, the most a GameState can hold.
+ *
+ * The 200000-pack row (10.4M cards, where shuffles go parallel) only runs
+ * with --max-packs 200000; compare shuffle with shuffle_1t for scaling.
+ */
+
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "deck.h"
+#include "game.h"
+#include "gameBatch.h"
+#include "gameState.h"
+#include "matchScan.h"
+#include "shuffle.h"
+
+#define BACKEND DECK_BACKEND_NAME
+
+/* ---------------- allocation counting ---------------- */
+
+static size_t alloc_calls;
+static size_t alloc_bytes;
+
+#if defined(__GLIBC__)
+#define COUNTS_ALLOCS 1
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t n, size_t size);
+extern void* __libc_realloc(void* p, size_t size);
+extern void __libc_free(void* p);
+
+void* malloc(size_t size)
+{
+    alloc_calls++;
+    alloc_bytes += size;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size)
+{
+    alloc_calls++;
+    alloc_bytes += n * size;
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* p, size_t size)
+{
+    alloc_calls++;
+    alloc_bytes += size;
+    return __libc_realloc(p, size);
+}
+
+void free(void* p)
+{
+    __libc_free(p);
+}
+#else
+#define COUNTS_ALLOCS 0
+#endif
+
+/* ---------------- timing ---------------- */
+
+static double now_ns(void)
+{
+    struct timespec ts;
+#if defined(CLOCK_MONOTONIC)
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+    timespec_get(&ts, TIME_UTC);
+#endif
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/* what a case measured: time and allocations inside its TIMED region */
+typedef struct {
+    double ns;
+    size_t calls;
+    size_t bytes;
+} Sample;
+
+/* run stmt and add its time and allocations to sample s; setup outside
+ * TIMED (building the input deck, freeing it) is not counted */
+#define TIMED(s, stmt) do {                         \
+        size_t calls_ = alloc_calls;                \
+        size_t bytes_ = alloc_bytes;                \
+        double start_ = now_ns();                   \
+        stmt;                                       \
+        (s)->ns += now_ns() - start_;               \
+        (s)->calls += alloc_calls - calls_;         \
+        (s)->bytes += alloc_bytes - bytes_;         \
+    } while (0)
+
+/* one benchmark body: works on `packs` packs and returns operations timed */
+typedef long long (*BenchFn)(int packs, Rng* rng, Sample* s);
+
+typedef struct {
+    const char* name;
+    BenchFn fn;
+    int max_packs;      /* largest pack count the case supports; 0 for any */
+} BenchCase;
+
+/* a random card, for filling decks in an unsorted order */
+static Card random_card(Rng* rng)
+{
+    return card_create((Suit)rng_bounded(rng, 4), (Rank)(TWO + rng_bounded(rng, 13)));
+}
+
+/* ---------------- cases ---------------- */
+
+/* a deck of packs * 52 random cards, not timed */
+static void random_deck(CardDeck* d, int packs, Rng* rng)
+{
+    carddeck_init(d);
+    for (int i = 0; i < packs * 52; i++)
+        carddeck_push_top(d, random_card(rng));
+}
+
+static long long bench_create(int packs, Rng* rng, Sample* s)
+{
+    (void)rng;
+    CardDeck d;
+    TIMED(s, carddeck_init_packs(&d, packs));
+    carddeck_free(&d);
+    return 1;
+}
+
+static long long bench_shuffle(int packs, Rng* rng, Sample* s)
+{
+    CardDeck d;
+    carddeck_init_packs(&d, packs);
+    TIMED(s, carddeck_shuffle(&d, rng));
+    carddeck_free(&d);
+    return 1;
+}
+
+/* the same shuffle held to one thread, for the parallel speed-up */
+static long long bench_shuffle_1t(int packs, Rng* rng, Sample* s)
+{
+    CardDeck d;
+    carddeck_init_packs(&d, packs);
+    Card* cards = carddeck_to_array(&d);
+    TIMED(s, card_shuffle_threads(cards, carddeck_size(&d), rng, 1));
+    free(cards);
+    carddeck_free(&d);
+    return 1;
+}
+
+static long long bench_sort(int packs, Rng* rng, Sample* s)
+{
+    CardDeck d;
+    random_deck(&d, packs, rng);
+    TIMED(s, carddeck_sort(&d));
+    carddeck_free(&d);
+    return 1;
+}
+
+static long long bench_add_top(int packs, Rng* rng, Sample* s)
+{
+    (void)rng;
+    CardDeck d;
+    int n = packs * 52;
+    carddeck_init(&d);
+    TIMED(s, for (int i = 0; i < n; i++) carddeck_push_top(&d, card_create((Suit)(i & 3), (Rank)(TWO + i % 13))));
+    carddeck_free(&d);
+    return n;
+}
+
+static long long bench_add_bottom(int packs, Rng* rng, Sample* s)
+{
+    (void)rng;
+    CardDeck d;
+    int n = packs * 52;
+    carddeck_init(&d);
+    TIMED(s, for (int i = 0; i < n; i++) carddeck_push_bottom(&d, card_create((Suit)(i & 3), (Rank)(TWO + i % 13))));
+    carddeck_free(&d);
+    return n;
+}
+
+static long long bench_pop_top(int packs, Rng* rng, Sample* s)
+{
+    (void)rng;
+    CardDeck d;
+    carddeck_init_packs(&d, packs);
+    int64_t n = carddeck_size(&d);
+    TIMED(s, while (carddeck_pop_top(&d, NULL)));
+    carddeck_free(&d);
+    return n;
+}
+
+static long long bench_remove_at(int packs, Rng* rng, Sample* s)
+{
+    CardDeck d;
+    carddeck_init_packs(&d, packs);
+    int64_t n = carddeck_size(&d);
+    TIMED(s, while (!carddeck_is_empty(&d)) carddeck_remove_at(&d, (int)rng_bounded(rng, (uint32_t)carddeck_size(&d)), NULL));
+    carddeck_free(&d);
+    return n;
+}
+
+static long long bench_to_array(int packs, Rng* rng, Sample* s)
+{
+    (void)rng;
+    CardDeck d;
+    Card* cards;
+    carddeck_init_packs(&d, packs);
+    TIMED(s, cards = carddeck_to_array(&d));
+    free(cards);
+    carddeck_free(&d);
+    return 1;
+}
+
+static long long bench_deal(int packs, Rng* rng, Sample* s)
+{
+    (void)rng;
+    CardDeck d;
+    CardView views[4];
+    Hand hands[4];
+    Card* scratch = malloc(sizeof(Card) * (size_t)packs * 52);
+    carddeck_init_packs(&d, packs);
+    for (int p = 0; p < 4; p++)
+        hand_init(&hands[p]);
+    TIMED(s, {
+        carddeck_deal_views(&d, 4, packs * 13, views, scratch);
+        for (int p = 0; p < 4; p++)
+            hand_insert_all(&hands[p], views[p].cards, views[p].size);
+    });
+    for (int p = 0; p < 4; p++)
+        hand_free(&hands[p]);
+    free(scratch);
+    carddeck_free(&d);
+    return packs * 52;
+}
+
+static long long bench_match(int packs, Rng* rng, Sample* s)
+{
+    int n = packs * 52;
+    Card* cards = malloc(sizeof(Card) * (size_t)n);
+    for (int i = 0; i < n; i++)
+        cards[i] = random_card(rng);
+    TIMED(s, for (int t = 0; t < 52; t++) match_count(cards, n, card_create((Suit)(t & 3), (Rank)(TWO + t % 13))));
+    free(cards);
+    return 52;
+}
+
+static long long bench_game(int packs, Rng* rng, Sample* s)
+{
+    Game g;
+    memset(&g, 0, sizeof(g));
+    g.rng = *rng;
+    g.verbosity = VERBOSITY_QUIET;
+    TIMED(s, play_game(&g, packs));
+    *rng = g.rng;
+    return 1;
+}
+
+/* whole games through a GameBatch; compare ns/op with the game row */
+static long long bench_batch(int packs, Rng* rng, Sample* s)
+{
+    enum { LANES = BATCH_DEFAULT_LANES, GAMES = 16 * BATCH_DEFAULT_LANES };
+    GameBatch b;
+    BatchResult done[LANES];
+
+    if (batch_init(&b, LANES, packs) != 0)
+        return 0;
+    b.rng = *rng;
+    TIMED(s, {
+        batch_start(&b, GAMES);
+        while (batch_running(&b))
+            batch_step(&b, done);
+    });
+    *rng = b.rng;
+    batch_free(&b);
+    return GAMES;
+}
+
+/* one search step: clone the position, then apply and undo a legal move */
+static long long bench_state_step(int packs, Rng* rng, Sample* s)
+{
+    Game g;
+    GameState root;
+    memset(&g, 0, sizeof(g));
+    g.rng = *rng;
+    g.verbosity = VERBOSITY_QUIET;
+    game_start(&g, packs);
+    gamestate_from_game(&root, &g);
+    *rng = g.rng;
+    game_free(&g);
+
+    int moves[GAMESTATE_MAX_MOVES];
+    int n = gamestate_legal_moves(&root, moves);
+    long long sink = 0;
+    TIMED(s, for (int i = 0; i < 1000; i++) {
+        GameState work;
+        GameUndo undo;
+        gamestate_clone(&work, &root);
+        gamestate_apply(&work, moves[i % n], rng, &undo);
+        gamestate_undo(&work, &undo);
+        sink += work.handSize[0];
+    });
+    if (sink < 0)
+        printf("%lld\n", sink);    /* keeps the loop from being optimised out */
+    return 1000;
+}
+
+static const BenchCase cases[] = {
+    { "create", bench_create, 0 },
+    { "shuffle", bench_shuffle, 0 },
+    { "shuffle_1t", bench_shuffle_1t, 0 },
+    { "sort", bench_sort, 0 },
+    { "add_top", bench_add_top, 0 },
+    { "add_bottom", bench_add_bottom, 0 },
+    { "pop_top", bench_pop_top, 0 },
+    { "remove_at", bench_remove_at, 0 },
+    { "to_array", bench_to_array, 0 },
+    { "deal", bench_deal, 0 },
+    { "match", bench_match, 0 },
+    { "game", bench_game, 0 },
+    { "batch", bench_batch, BATCH_MAX_PACKS },
+    { "state_step", bench_state_step, GAMESTATE_MAX_PACKS },
+};
+
+/* ---------------- runner ---------------- */
+
+static const int pack_counts[] = { 1, 10, 100, 1000, 10000, 200000 };
+
+#define MIN_SAMPLE_NS 2e7 /* repeat a case until its timed regions add up to this */
+
+/* run every case at every pack count and print CSV */
+static void run_all(int max_packs, double budget_s)
+{
+    printf("backend,op,packs,iters,ns_per_op,bytes_per_op,allocs_per_op\n");
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        double last_iter_ns = 0;   /* wall time per iteration, setup included */
+
+        for (size_t p = 0; p < sizeof(pack_counts) / sizeof(pack_counts[0]); p++) {
+            int packs = pack_counts[p];
+            if (packs > max_packs || (cases[c].max_packs && packs > cases[c].max_packs))
+                break;
+
+            /* quadratic cases get 100x slower per 10x packs; stop early */
+            if (last_iter_ns * 100.0 > budget_s * 1e9) {
+                printf("# %s,%s,%d skipped: over %.1fs budget\n", BACKEND, cases[c].name, packs, budget_s);
+                break;
+            }
+
+            Rng rng;
+            rng_seed(&rng, 12345);
+
+            Sample sample = { 0, 0, 0 };
+            long long iters = 0, ops = 0;
+            double wall = now_ns();
+            do {
+                ops += cases[c].fn(packs, &rng, &sample);
+                iters++;
+            } while (sample.ns < MIN_SAMPLE_NS);
+
+            last_iter_ns = (now_ns() - wall) / (double)iters;
+            printf("%s,%s,%d,%lld,%.2f,%.1f,%.3f\n", BACKEND, cases[c].name, packs, iters,
+                sample.ns / (double)ops,
+                COUNTS_ALLOCS ? (double)sample.bytes / (double)ops : -1.0,
+                COUNTS_ALLOCS ? (double)sample.calls / (double)ops : -1.0);
+            fflush(stdout);
+        }
+    }
+}
+
+/* ---------------- compare mode ---------------- */
+
+typedef struct {
+    char key[96];   /* "backend,op,packs" */
+    double ns;
+} Row;
+
+/* read the data rows of a bench CSV; returns count, or -1 if unreadable */
+static int load_rows(const char* path, Row* rows, int max)
+{
+    FILE* f = fopen(path, "r");
+    char line[256];
+    int n = 0;
+
+    if (!f)
+        return -1;
+
+    while (n < max && fgets(line, sizeof(line), f)) {
+        char backend[32], op[32];
+        int packs;
+        long long iters;
+        double ns;
+
+        if (line[0] == '#' || strncmp(line, "backend,", 8) == 0)
+            continue;
+        if (sscanf(line, "%31[^,],%31[^,],%d,%lld,%lf", backend, op, &packs, &iters, &ns) != 5)
+            continue;
+        snprintf(rows[n].key, sizeof(rows[n].key), "%s,%s,%d", backend, op, packs);
+        rows[n].ns = ns;
+        n++;
+    }
+    fclose(f);
+    return n;
+}
+
+/* print old/new ns per op for matching rows; 1 if any regressed */
+static int compare(const char* old_path, const char* new_path, double threshold)
+{
+    static Row old_rows[512], new_rows[512];
+    int n_old = load_rows(old_path, old_rows, 512);
+    int n_new = load_rows(new_path, new_rows, 512);
+    int regressions = 0;
+
+    if (n_old < 0 || n_new < 0) {
+        fprintf(stderr, "cannot read %s\n", n_old < 0 ? old_path : new_path);
+        return 2;
+    }
+
+    printf("case,old_ns,new_ns,change_pct,status\n");
+    for (int i = 0; i < n_new; i++) {
+        for (int j = 0; j < n_old; j++) {
+            if (strcmp(new_rows[i].key, old_rows[j].key) != 0)
+                continue;
+            double change = (new_rows[i].ns / old_rows[j].ns - 1.0) * 100.0;
+            const char* status = change > threshold ? "REGRESSION" : (change < -threshold ? "improved" : "ok");
+            if (change > threshold)
+                regressions++;
+            printf("%s,%.2f,%.2f,%+.1f,%s\n", new_rows[i].key, old_rows[j].ns, new_rows[i].ns, change, status);
+            break;
+        }
+    }
+    return regressions ? 1 : 0;
+}
+
+int main(int argc, char* argv[])
+{
+    int max_packs = 10000;
+    double budget = 2.0;
+    double threshold = 10.0;
+
+    if (argc >= 4 && strcmp(argv[1], "--compare") == 0) {
+        if (argc >= 6 && strcmp(argv[4], "--threshold") == 0)
+            threshold = atof(argv[5]);
+        return compare(argv[2], argv[3], threshold);
+    }
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--max-packs") == 0)
+            max_packs = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--budget") == 0)
+            budget = atof(argv[i + 1]);
+    }
+
+    run_all(max_packs, budget);
+    return 0;
+}
@@ -1,93 +1,189 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "Card.h"
+#include "perf.h"
 
- /* Internal arrays for names */
-static const char* suit_names[] = {
-    "Club",
-    "Diamond",
-    "Heart",
-    "Spade"
+ /* Internal arrays for names, with lengths so formatting is plain copies */
+typedef struct {
+    const char* str;
+    size_t len;
+} Name;
+
+#define NAME(s) { s, sizeof(s) - 1 }
+
+/* indexed by the 4-bit suit field; values past DIAMOND are invalid */
+static const Name suit_names[16] = {
+    NAME("Club"),
+    NAME("Spade"),
+    NAME("Heart"),
+    NAME("Diamond"),
+    NAME("UnknownSuit"), NAME("UnknownSuit"), NAME("UnknownSuit"), NAME("UnknownSuit"),
+    NAME("UnknownSuit"), NAME("UnknownSuit"), NAME("UnknownSuit"), NAME("UnknownSuit"),
+    NAME("UnknownSuit"), NAME("UnknownSuit"), NAME("UnknownSuit"), NAME("UnknownSuit")
 };
 
-static const char* rank_names[] = {
+/* indexed by the 4-bit rank field */
+static const Name rank_names[16] = {
     /* index 0-1 unused to align with enum numeric ranks starting at 2 */
-    NULL,
-    NULL,
-    "Two",
-    "Three",
-    "Four",
-    "Five",
-    "Six",
-    "Seven",
-    "Eight",
-    "Nine",
-    "Ten",
-    "Jack",
-    "Queen",
-    "King",
-    "Ace"
+    NAME("UnknownRank"),
+    NAME("UnknownRank"),
+    NAME("Two"),
+    NAME("Three"),
+    NAME("Four"),
+    NAME("Five"),
+    NAME("Six"),
+    NAME("Seven"),
+    NAME("Eight"),
+    NAME("Nine"),
+    NAME("Ten"),
+    NAME("Jack"),
+    NAME("Queen"),
+    NAME("King"),
+    NAME("Ace"),
+    NAME("UnknownRank")
 };
 
-/* Create a Card */
-Card card_create(CardSuit suit, CardRank rank)
+/* Create a Card packed into one byte */
+Card card_create(Suit suit, Rank rank)
 {
     Card c;
-    c.suit = suit;
-    c.rank = rank;
+    c.bits = (uint8_t)(((unsigned)suit << CARD_SUIT_SHIFT) | (unsigned)rank);
     return c;
 }
 
-/* Convert to string. Uses static buffer overwritten on each call. */
-const char* card_to_string(Card c)
+/* Format "Spade-Five" into buf without a terminator; buf has room for CARD_STRING_MAX */
+static size_t card_render(Card c, char* buf)
 {
-    static char buf[32];
-    const char* suit_str = "UnknownSuit";
-    const char* rank_str = "UnknownRank";
+    const Name* suit = &suit_names[c.bits >> CARD_SUIT_SHIFT];
+    const Name* rank = &rank_names[c.bits & CARD_RANK_MASK];
 
-    if (c.suit >= CLUB && c.suit <= SPADE) {
-        suit_str = suit_names[c.suit];
-    }
+    memcpy(buf, suit->str, suit->len);
+    buf[suit->len] = '-';
+    memcpy(buf + suit->len + 1, rank->str, rank->len);
+    return suit->len + 1 + rank->len;
+}
+
+/* Reentrant formatter; truncates like snprintf and returns the full length */
+size_t card_format(Card c, char* buf, size_t size)
+{
+    char tmp[CARD_STRING_MAX];
+    size_t len = card_render(c, tmp);
 
-    /* rank enum values start at 2 */
-    if ((int)c.rank >= 2 && (int)c.rank <= 14) {
-        rank_str = rank_names[(int)c.rank];
+    if (size > 0) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(buf, tmp, n);
+        buf[n] = '\0';
     }
+    return len;
+}
 
-    /* format "Spade-Five" */
-    snprintf(buf, sizeof(buf), "%s-%s", suit_str, rank_str);
+/* Convert to string. Uses static buffer overwritten on each call. */
+const char* card_to_string(Card c)
+{
+    static char buf[CARD_STRING_MAX];
+    card_format(c, buf, sizeof(buf));
     return buf;
 }
 
 /* Print a card to stdout; newline if requested */
 void card_print(Card c, int newline)
 {
-    const char* s = card_to_string(c);
+    char buf[CARD_STRING_MAX];
+    size_t len = card_render(c, buf);
     if (newline) {
-        printf("%s\n", s);
+        buf[len++] = '\n';
     }
-    else {
-        printf("%s", s);
+    fwrite(buf, 1, len, stdout);
+}
+
+/* Render one card per line; only whole lines that fit are written */
+size_t deck_format(const Card* cards, int64_t count, char* buf, size_t size)
+{
+    size_t total = 0;
+
+    for (int64_t i = 0; i < count; i++) {
+        const Name* suit = &suit_names[cards[i].bits >> CARD_SUIT_SHIFT];
+        const Name* rank = &rank_names[cards[i].bits & CARD_RANK_MASK];
+        size_t line = suit->len + 1 + rank->len + 1;
+
+        if (buf && total + line <= size) {
+            card_render(cards[i], buf + total);
+            buf[total + line - 1] = '\n';
+        }
+        total += line;
     }
+    return total;
+}
+
+/* Render into one buffer and hand it to stdio in a single fwrite */
+int deck_write(const Card* cards, int64_t count, FILE* out)
+
+{
+    char small[4096];
+    size_t len = deck_format(cards, count, NULL, 0);
+    char* buf = len <= sizeof(small) ? small : malloc(len);
+
+    if (!buf)
+        return -1;
+
+    deck_format(cards, count, buf, len);
+    size_t written = fwrite(buf, 1, len, out);
+
+    if (buf != small)
+        free(buf);
+    return written == len ? 0 : -1;
 }
 
 /* Return 1 if suits or ranks match */
 int card_matches(Card a, Card b)
 {
-    if (a.suit == b.suit) {
-        return 1;
+    /* differing bits are zero in a field when that field matches */
+    unsigned diff = (unsigned)(a.bits ^ b.bits);
+    return (diff & CARD_SUIT_MASK) == 0 || (diff & CARD_RANK_MASK) == 0;
+}
+
+/* Counting sort: histogram the packed bytes, then write them back in order */
+void card_sort(Card* cards, int64_t count)
+{
+    int64_t hist[CARD_KEYS] = { 0 };
+    PERF_TIMER(start);
+
+    for (int64_t i = 0; i < count; i++) {
+        hist[cards[i].bits]++;
+    }
+
+    int64_t out = 0;
+    for (int key = 0; key < CARD_KEYS; key++) {
+        memset(cards + out, key, (size_t)hist[key]);
+        out += hist[key];
+    }
+    PERF_COUNT(PERF_SORTS, 1);
+    PERF_RECORD(PERF_HIST_SORT, start);
+}
+
+/* Same counting sort, writing the highest key first */
+void card_sort_desc(Card* cards, int64_t count)
+{
+    int64_t hist[CARD_KEYS] = { 0 };
+    PERF_TIMER(start);
+
+    for (int64_t i = 0; i < count; i++) {
+        hist[cards[i].bits]++;
     }
-    if (a.rank == b.rank) {
-        return 1;
+
+    int64_t out = 0;
+    for (int key = CARD_KEYS - 1; key >= 0; key--) {
+        memset(cards + out, key, (size_t)hist[key]);
+        out += hist[key];
     }
-    return 0;
+    PERF_COUNT(PERF_SORTS, 1);
+    PERF_RECORD(PERF_HIST_SORT, start);
 }
 
 /* Compare two cards for ordering (suit then rank) */
 int card_compare(const Card* a, const Card* b)
 {
-    if (a->suit != b->suit) {
-        return (int)a->suit - (int)b->suit;
-    }
-    /* rank numeric comparison (RANK_TWO..RANK_ACE) */
-    return (int)a->rank - (int)b->rank;
+    /* suit sits above rank in the packed byte, so one compare does both */
+    return (int)a->bits - (int)b->bits;
 }
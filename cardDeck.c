@@ -1,131 +1,283 @@
-/**
- * @file CardDeck.c
- * @brief Implementats CardDeck operations.
- * Author Sean Carroll
- */
-
-#include "CardDeck.h"
-#include <stdio.h>
-#include <stdlib.h>
-#include <time.h>
-
-
-void printCard(Card c);
-
-/**
- * @brief createDeck creates a deck with numPacks of cards.
- * @param numPacks How many full sets to include.
- * @return A CardDeck with all requested packs.
- */
-CardDeck createDeck(int numPacks) {
-    CardDeck deck;
-    deck.size = numPacks * 52;
-    deck.cards = (Card*)malloc(deck.size * sizeof(Card));
-
-    int index = 0;
-    for (int p = 0; p < numPacks; p++) {
-        for (int s = CLUBS; s <= DIAMONDS; s++) {
-            for (int r = TWO; r <= ACE; r++) {
-                deck.cards[index].suit = (Suit)s;
-                deck.cards[index].rank = (Rank)r;
-                index++;
-            }
-        }
-    }
-    return deck;
-}
-
-/**
- * @brief freeDeck frees the memory by clearing out the deck.
- * @param deck Pointer to the deck you want to clean up.
- */
-void freeDeck(CardDeck* deck) {
-    free(deck->cards);
-    deck->cards = NULL;
-    deck->size = 0;
-}
-
-/**
- * @brief shuffleDeck shuffles all the cards in the deck randomly.
- * @param Pointer to the deck to shuffle.
- */
-void shuffleDeck(CardDeck* deck) {
-    srand((unsigned int)time(NULL)); // cast to avoid warning
-    for (int i = 0; i < deck->size; i++) {
-        int j = rand() % deck->size;
-        Card temp = deck->cards[i];
-        deck->cards[i] = deck->cards[j];
-        deck->cards[j] = temp;
-    }
-}
-
-/**
- * @brief bubbleSortDeck sorts the deck using bubble sort.
- * @param deck Pointer to the deck you want to sort.
- */
-void bubbleSortDeck(CardDeck* deck) {
-    for (int i = 0; i < deck->size - 1; i++) {
-        for (int j = 0; j < deck->size - i - 1; j++) {
-            if (deck->cards[j + 1].suit < deck->cards[j].suit ||
-                (deck->cards[j + 1].suit == deck->cards[j].suit &&
-                    deck->cards[j + 1].rank < deck->cards[j].rank)) {
-                Card temp = deck->cards[j];
-                deck->cards[j] = deck->cards[j + 1];
-                deck->cards[j + 1] = temp;
-            }
-        }
-    }
-}
-
-/**
- * @brief removeTopCard takes the top card from the deck and puts it back.
- * @param deck Pointer to the CardDeck to remove the top card from.
- * @return The top Card from the deck.
- */
-Card removeTopCard(CardDeck* deck) {
-    if (deck->size == 0) {
-        Card empty = { CLUBS, TWO };
-        return empty;
-    }
-    Card top = deck->cards[deck->size - 1];
-    deck->size--;
-    return top;
-}
-
-/**
- * @brief addCard adds a new card to the bottom of the deck.
- * @param deck Pointer to the CardDeck to adding the card to.
- * @param c The Card to add.
- */
-void addCard(CardDeck* deck, Card c) {
-    Card* temp = (Card*)realloc(deck->cards, (deck->size + 1) * sizeof(Card));
-    if (temp == NULL) {
-        printf("Error: Unable to allocate memory for new card.\n");
-        return;
-    }
-    deck->cards = temp;
-    deck->cards[deck->size] = c;
-    deck->size++;
-}
-
-/**
- * @brief printDeck prints every card in the deck.
- * @param deck Pointer to the card you want to print.
- */
-void printDeck(CardDeck* deck) {
-    for (int i = 0; i < deck->size; i++) {
-        printCard(deck->cards[i]);
-    }
-}
-
-/**
- * @brief printCard prints a single card in readable format.
- * @param c The card you want to print.
- */
-void printCard(Card c) {
-    const char* suits[] = { "Clubs", "Spades", "Hearts", "Diamonds" };
-    const char* ranks[] = { "", "", "2","3","4","5","6","7","8","9","10",
-                            "Jack","Queen","King","Ace" };
-    printf("%s of %s\n", ranks[c.rank], suits[c.suit]);
-}
-
+/**
+ * @file CardDeck.c
+ * @brief Implementats CardDeck operations.
+ * Author Sean Carroll
+ */
+
+#include "cardDeck.h"
+#include "perf.h"
+#include "shuffle.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+void printCard(Card c);
+
+/**
+ * @brief createDeck creates a deck with numPacks of cards.
+ * @details The top of the deck is the end of the array, so the cards are
+ *          written back to front: the first card of the first pack is on
+ *          top, the same order the linked-list deck deals in.
+ *          The array is allocated once, at exactly the size needed.
+ * @param numPacks How many full sets to include.
+ * @return A CardDeck with all requested packs.
+ */
+CardDeck createDeck(int64_t numPacks) {
+    CardDeck deck;
+    initDeck(&deck);
+    if (numPacks <= 0) {
+        return deck;
+    }
+
+    if ((uint64_t)numPacks > SIZE_MAX / 52) {
+        fprintf(stderr, "Deck of %lld packs is too large in createDeck()\n", (long long)numPacks);
+        exit(EXIT_FAILURE);
+    }
+    deck.size = numPacks * 52;
+    deck.capacity = deck.size;
+    deck.cards = (Card*)malloc((size_t)deck.size * sizeof(Card));
+    if (deck.cards == NULL) {
+        fprintf(stderr, "Memory allocation failed in createDeck()\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int64_t index = deck.size - 1;
+    for (int64_t p = 0; p < numPacks; p++) {
+        for (int s = CLUB; s <= DIAMOND; s++) {
+            for (int r = TWO; r <= ACE; r++) {
+                deck.cards[index] = card_create((Suit)s, (Rank)r);
+                index--;
+            }
+        }
+    }
+    return deck;
+}
+
+/**
+ * @brief initDeck makes an empty deck that owns no memory yet.
+ * @param deck Pointer to the deck to initialize.
+ */
+void initDeck(CardDeck* deck) {
+    deck->cards = NULL;
+    deck->size = 0;
+    deck->capacity = 0;
+}
+
+/**
+ * @brief freeDeck frees the memory by clearing out the deck.
+ * @param deck Pointer to the deck you want to clean up.
+ */
+void freeDeck(CardDeck* deck) {
+    free(deck->cards);
+    initDeck(deck);
+}
+
+/**
+ * @brief reserveDeck makes room for at least capacity cards.
+ * @details Does nothing if the deck is already that big. Otherwise grows
+ *          by the growth policy, or straight to capacity if that is more,
+ *          so repeated adds cost amortized O(1) copying.
+ * @param deck Pointer to the deck to grow.
+ * @param capacity Number of cards the deck must be able to hold.
+ * @return 1 on success, 0 if memory ran out (the deck is unchanged).
+ */
+int reserveDeck(CardDeck* deck, int64_t capacity) {
+    if (capacity <= deck->capacity) {
+        return 1;
+    }
+    if ((uint64_t)capacity > SIZE_MAX / sizeof(Card)) {
+        return 0;
+    }
+
+    int64_t cap = deck->capacity <= INT64_MAX / CARDDECK_GROWTH_PERCENT
+        ? deck->capacity * CARDDECK_GROWTH_PERCENT / 100 : capacity;
+    if (cap < CARDDECK_MIN_CAPACITY) {
+        cap = CARDDECK_MIN_CAPACITY;
+    }
+    if (cap < capacity || (uint64_t)cap > SIZE_MAX / sizeof(Card)) {
+        cap = capacity;
+    }
+
+    Card* temp = (Card*)realloc(deck->cards, (size_t)cap * sizeof(Card));
+    PERF_COUNT(PERF_DECK_REALLOC, 1);
+    if (temp == NULL) {
+        return 0;
+    }
+    deck->cards = temp;
+    deck->capacity = cap;
+    return 1;
+}
+
+/**
+ * @brief shrinkDeckToFit gives back the memory the deck is not using.
+ * @details An empty deck frees its array entirely.
+ * @param deck Pointer to the deck to shrink.
+ */
+void shrinkDeckToFit(CardDeck* deck) {
+    if (deck->size == deck->capacity) {
+        return;
+    }
+    if (deck->size == 0) {
+        freeDeck(deck);
+        return;
+    }
+
+    Card* temp = (Card*)realloc(deck->cards, (size_t)deck->size * sizeof(Card));
+    PERF_COUNT(PERF_DECK_REALLOC, 1);
+    if (temp != NULL) {
+        deck->cards = temp;
+        deck->capacity = deck->size;
+    }
+}
+
+/**
+ * @brief shuffleDeck shuffles all the cards in the deck randomly.
+ * @details Fisher-Yates: each card swaps with a uniformly chosen card at or
+ *          below it, so every ordering is equally likely. Shoes of
+ *          SHUFFLE_PARALLEL_MIN cards or more use the multi-threaded bucket
+ *          shuffle from shuffle.h instead.
+ *          The shuffle runs over the cards top first, as the list and ring
+ *          decks do, so a seed deals the same game on every backend.
+ * @param deck Pointer to the deck to shuffle.
+ * @param rng Generator to draw from; seed it for a repeatable shuffle.
+ */
+void shuffleDeck(CardDeck* deck, Rng* rng) {
+    card_shuffle_reversed(deck->cards, deck->size, rng);
+}
+
+/**
+ * @brief sortDeck sorts the deck into card_compare order in linear time.
+ * @details The lowest card ends up on top (the end of the array), as on
+ *          the list and ring decks.
+ * @param deck Pointer to the deck you want to sort.
+ */
+void sortDeck(CardDeck* deck) {
+    card_sort_desc(deck->cards, deck->size);
+}
+
+/**
+ * @brief bubbleSortDeck sorts the deck. Kept for existing callers; it is
+ *        the same linear-time counting sort as sortDeck.
+ * @param deck Pointer to the deck you want to sort.
+ */
+void bubbleSortDeck(CardDeck* deck) {
+    sortDeck(deck);
+}
+
+/**
+ * @brief removeTopCard takes the top card from the deck and puts it back.
+ * @param deck Pointer to the CardDeck to remove the top card from.
+ * @return The top Card from the deck.
+ */
+Card removeTopCard(CardDeck* deck) {
+    if (deck->size == 0) {
+        Card empty = card_create(CLUB, TWO);
+        return empty;
+    }
+    Card top = deck->cards[deck->size - 1];
+    deck->size--;
+    return top;
+}
+
+/**
+ * @brief addCard puts a new card on top of the deck (the end of the array).
+ * @details Amortized O(1): the array only reallocates when it is full.
+ * @param deck Pointer to the CardDeck to adding the card to.
+ * @param c The Card to add.
+ */
+void addCard(CardDeck* deck, Card c) {
+    if (!reserveDeck(deck, deck->size + 1)) {
+        printf("Error: Unable to allocate memory for new card.\n");
+        return;
+    }
+    deck->cards[deck->size] = c;
+    deck->size++;
+}
+
+/**
+ * @brief addCards puts count cards on top of the deck with one copy.
+ * @details cards[count - 1] ends up on top, as if each card had been
+ *          passed to addCard in array order.
+ * @param deck Pointer to the CardDeck to add the cards to.
+ * @param cards The cards to add.
+ * @param count How many cards to add.
+ */
+void addCards(CardDeck* deck, const Card* cards, int64_t count) {
+    if (count <= 0) {
+        return;
+    }
+    if (!reserveDeck(deck, deck->size + count)) {
+        printf("Error: Unable to allocate memory for new cards.\n");
+        return;
+    }
+    memcpy(deck->cards + deck->size, cards, (size_t)count * sizeof(Card));
+    deck->size += count;
+}
+
+static const char* suitNames[] = { "Clubs", "Spades", "Hearts", "Diamonds" };
+static const char* rankNames[] = { "", "", "2","3","4","5","6","7","8","9","10",
+                                   "Jack","Queen","King","Ace", "" };
+
+#define CARD_LINE_MAX 24 /* longest "<rank> of <suit>\n" is 18 bytes */
+
+/**
+ * @brief formatCardLine writes "<rank> of <suit>\n" without printf.
+ * @param c The card to format.
+ * @param buf Destination with room for CARD_LINE_MAX bytes.
+ * @return Number of bytes written.
+ */
+static size_t formatCardLine(Card c, char* buf) {
+    const char* rank = rankNames[card_rank(c)];
+    const char* suit = suitNames[card_suit(c) & 3];
+    size_t rankLen = strlen(rank);
+    size_t suitLen = strlen(suit);
+
+    memcpy(buf, rank, rankLen);
+    memcpy(buf + rankLen, " of ", 4);
+    memcpy(buf + rankLen + 4, suit, suitLen);
+    buf[rankLen + 4 + suitLen] = '\n';
+    return rankLen + 4 + suitLen + 1;
+}
+
+/**
+ * @brief printDeck prints every card in the deck, top card first.
+ * @details Renders the whole deck into one buffer and writes it at once.
+ * @param deck Pointer to the card you want to print.
+ */
+void printDeck(CardDeck* deck) {
+    char small[4096];
+    size_t cap = (size_t)deck->size * CARD_LINE_MAX;
+
+    if (deck->size <= 0) {
+        return;
+    }
+
+    char* buf = cap <= sizeof(small) ? small : (char*)malloc(cap);
+
+    if (buf == NULL) {
+        printf("Error: Unable to allocate memory to print deck.\n");
+        return;
+    }
+
+    size_t len = 0;
+    for (int64_t i = deck->size - 1; i >= 0; i--) {
+        len += formatCardLine(deck->cards[i], buf + len);
+    }
+
+    fwrite(buf, 1, len, stdout);
+
+    if (buf != small) {
+        free(buf);
+    }
+}
+
+/**
+ * @brief printCard prints a single card in readable format.
+ * @param c The card you want to print.
+ */
+void printCard(Card c) {
+    char buf[CARD_LINE_MAX];
+    fwrite(buf, 1, formatCardLine(c, buf), stdout);
+}
+
@@ -1,51 +1,51 @@
-/**
- * @file CardDeck.h
- * @brief Declaration of Card, CardDeck, and related operations.
- * Author: Sean Carroll
- */
-
-#ifndef CARDDECK_H
-#define CARDDECK_H
-
- /**
-  * @enum Suit
-  * @brief The four suits in a standard deck.
-  */
-typedef enum { CLUBS, SPADES, HEARTS, DIAMONDS } Suit;
-
-/**
- * @enum Rank
- * @brief The ranks in a standard deck.
- */
-typedef enum {
-    TWO = 2, THREE, FOUR, FIVE, SIX, SEVEN, EIGHT, NINE, TEN,
-    JACK, QUEEN, KING, ACE
-} Rank;
-
-/**
- * @struct Card
- * @brief Represents a single playing card.
- */
-typedef struct {
-    Suit suit;
-    Rank rank;
-} Card;
-
-/**
- * @struct CardDeck
- * @brief A dynamic array of cards and a size counter.
- */
-typedef struct {
-    Card* cards;  /**< Pointer to dynamic array of cards */
-    int size;     /**< Current number of cards in the deck */
-} CardDeck;
-
-CardDeck createDeck(int numPacks);
-void freeDeck(CardDeck* deck);
-void shuffleDeck(CardDeck* deck);
-void bubbleSortDeck(CardDeck* deck);
-Card removeTopCard(CardDeck* deck);
-void addCard(CardDeck* deck, Card c);
-void printDeck(CardDeck* deck);
-
-#endif
+/**
+ * @file CardDeck.h
+ * @brief Declaration of Card, CardDeck, and related operations.
+ * Author: Sean Carroll
+ */
+
+#ifndef CARDDECK_ARRAY_H
+#define CARDDECK_ARRAY_H
+
+#include <stdint.h>
+#include "Card.h"
+#include "rng.h"
+
+/*
+ * Growth policy: when a deck runs out of room its capacity becomes
+ * capacity * CARDDECK_GROWTH_PERCENT / 100, and never less than
+ * CARDDECK_MIN_CAPACITY. Define either before including this header (or
+ * with -D) to tune it.
+ */
+#ifndef CARDDECK_MIN_CAPACITY
+#define CARDDECK_MIN_CAPACITY 16
+#endif
+
+#ifndef CARDDECK_GROWTH_PERCENT
+#define CARDDECK_GROWTH_PERCENT 200
+#endif
+
+/**
+ * @struct CardDeck
+ * @brief A dynamic array of cards with a size and capacity.
+ */
+typedef struct {
+    Card* cards;  /**< Pointer to dynamic array of cards */
+    int64_t size;     /**< Current number of cards in the deck */
+    int64_t capacity; /**< Cards that fit in the array before it must grow */
+} CardDeck;
+
+CardDeck createDeck(int64_t numPacks);
+void initDeck(CardDeck* deck);
+void freeDeck(CardDeck* deck);
+int reserveDeck(CardDeck* deck, int64_t capacity);
+void shrinkDeckToFit(CardDeck* deck);
+void shuffleDeck(CardDeck* deck, Rng* rng);
+void sortDeck(CardDeck* deck);
+void bubbleSortDeck(CardDeck* deck);
+Card removeTopCard(CardDeck* deck);
+void addCard(CardDeck* deck, Card c);
+void addCards(CardDeck* deck, const Card* cards, int64_t count);
+void printDeck(CardDeck* deck);
+
+#endif
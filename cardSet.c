@@ -0,0 +1,52 @@
+#include "cardSet.h"
+
+/* ranks TWO..ACE occupy bits 2..14 of each 16-bit suit lane */
+#define SUIT_LANE 0x7FFCULL
+#define RANK_COLUMN 0x0001000100010001ULL
+
+const CardSet cardset_suit_mask[4] = {
+    SUIT_LANE << (CLUB << CARD_SUIT_SHIFT),
+    SUIT_LANE << (SPADE << CARD_SUIT_SHIFT),
+    SUIT_LANE << (HEART << CARD_SUIT_SHIFT),
+    SUIT_LANE << (DIAMOND << CARD_SUIT_SHIFT)
+};
+
+const CardSet cardset_rank_mask[15] = {
+    /* index 0-1 unused to align with enum numeric ranks starting at 2 */
+    0,
+    0,
+    RANK_COLUMN << TWO,
+    RANK_COLUMN << THREE,
+    RANK_COLUMN << FOUR,
+    RANK_COLUMN << FIVE,
+    RANK_COLUMN << SIX,
+    RANK_COLUMN << SEVEN,
+    RANK_COLUMN << EIGHT,
+    RANK_COLUMN << NINE,
+    RANK_COLUMN << TEN,
+    RANK_COLUMN << JACK,
+    RANK_COLUMN << QUEEN,
+    RANK_COLUMN << KING,
+    RANK_COLUMN << ACE
+};
+
+/* Build a set from an array of distinct cards */
+CardSet cardset_from_array(const Card* cards, int64_t count)
+{
+    CardSet s = CARDSET_EMPTY;
+    for (int64_t i = 0; i < count; i++) {
+        cardset_insert(&s, cards[i]);
+    }
+    return s;
+}
+
+/* Write cards out lowest first; no sort needed since bit order is card order */
+int cardset_to_array(CardSet s, Card* out)
+{
+    int n = 0;
+    Card c;
+    while (cardset_next(&s, &c)) {
+        out[n++] = c;
+    }
+    return n;
+}
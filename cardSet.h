@@ -0,0 +1,202 @@
+/**
+* @file cardSet.h
+* @brief A set of distinct cards stored as one 64-bit mask.
+*
+* Each card occupies the bit given by its packed byte (see Card.h), so a
+* single pack fits in one uint64_t and ascending bit order is exactly the
+* card_compare() order. Only use a CardSet where a card cannot appear twice,
+* i.e. hands and piles of single-pack games.
+*/
+#ifndef CARDSET_H
+#define CARDSET_H
+
+#include <stdint.h>
+#include "Card.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+/**
+* @brief Bitset of distinct cards. Bit n is set when the card whose packed
+*        byte equals n is present.
+*/
+typedef uint64_t CardSet;
+
+#define CARDSET_EMPTY ((CardSet)0) // Set with no cards
+
+extern const CardSet cardset_suit_mask[4]; // Every card of a suit, indexed by Suit
+extern const CardSet cardset_rank_mask[15]; // Every card of a rank, indexed by Rank (0-1 unused)
+
+
+/**
+* @brief Bit standing for a single card.
+*/
+static inline CardSet cardset_bit(Card c)
+{
+	return (CardSet)1 << c.bits;
+}
+
+
+/**
+* @brief Number of cards in the set.
+*/
+static inline int cardset_count(CardSet s)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_popcountll(s);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	return (int)__popcnt64(s);
+#else
+	int n = 0;
+	while (s) {
+		s &= s - 1; // Clear lowest set bit
+		n++;
+	}
+	return n;
+#endif
+}
+
+
+/**
+* @brief Index of the lowest set bit. The set must not be empty.
+*/
+static inline int cardset_lowest_bit(CardSet s)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(s);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long i;
+	_BitScanForward64(&i, s);
+	return (int)i;
+#else
+	int i = 0;
+	while (!(s & 1)) {
+		s >>= 1;
+		i++;
+	}
+	return i;
+#endif
+}
+
+
+/**
+* @brief Add a card to the set.
+*/
+static inline void cardset_insert(CardSet* s, Card c)
+{
+	*s |= cardset_bit(c);
+}
+
+
+/**
+* @brief Remove a card from the set (no effect if absent).
+*/
+static inline void cardset_remove(CardSet* s, Card c)
+{
+	*s &= ~cardset_bit(c);
+}
+
+
+/**
+* @brief Returns 1 if the card is in the set, 0 otherwise.
+*/
+static inline int cardset_contains(CardSet s, Card c)
+{
+	return (s & cardset_bit(c)) != 0;
+}
+
+
+/**
+* @brief Cards in either set.
+*/
+static inline CardSet cardset_union(CardSet a, CardSet b)
+{
+	return a | b;
+}
+
+
+/**
+* @brief Cards in both sets.
+*/
+static inline CardSet cardset_intersect(CardSet a, CardSet b)
+{
+	return a & b;
+}
+
+
+/**
+* @brief Every card that card_matches() the given top card.
+*/
+static inline CardSet cardset_match_mask(Card top)
+{
+	return cardset_suit_mask[card_suit(top)] | cardset_rank_mask[card_rank(top)];
+}
+
+
+/**
+* @brief Get the lowest card (card_compare order) in the set.
+* @param out Pointer where the card will be stored.
+* @return 1 if found, 0 if the set is empty.
+*/
+static inline int cardset_lowest(CardSet s, Card* out)
+{
+	if (!s)
+		return 0;
+	out->bits = (uint8_t)cardset_lowest_bit(s);
+	return 1;
+}
+
+
+/**
+* @brief Remove and return the lowest card; drives iteration in sorted order.
+*
+* Usage: CardSet it = hand; Card c; while (cardset_next(&it, &c)) { ... }
+*
+* @return 1 if a card was produced, 0 once the set is empty.
+*/
+static inline int cardset_next(CardSet* it, Card* out)
+{
+	if (!cardset_lowest(*it, out))
+		return 0;
+	*it &= *it - 1; // Clear lowest set bit
+	return 1;
+}
+
+
+/**
+* @brief Number of cards in the set that sort before c, i.e. the index c
+*        has (or would have) in the set's sorted order.
+*/
+static inline int cardset_rank_of(CardSet s, Card c)
+{
+	return cardset_count(s & (cardset_bit(c) - 1));
+}
+
+
+/**
+* @brief Find the lowest card in the hand matching the top card.
+* @param out Pointer where the matching card will be stored.
+* @return 1 if the hand holds a match, 0 otherwise.
+*/
+static inline int cardset_first_match(CardSet hand, Card top, Card* out)
+{
+	return cardset_lowest(hand & cardset_match_mask(top), out);
+}
+
+
+/**
+* @brief Build a set from an array of distinct cards.
+*/
+CardSet cardset_from_array(const Card* cards, int64_t count);
+
+
+/**
+* @brief Write the set's cards to an array in sorted order.
+* @param out Array with room for cardset_count(s) cards.
+* @return Number of cards written.
+*/
+int cardset_to_array(CardSet s, Card* out);
+
+#endif
@@ -1,195 +1,431 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include "carddeck.h"
-
-/**
- * @brief Initialize an empty deck.
- * @details Sets the deck's head pointer to NULL and size to 0.
- *          This function must be called before adding any cards.
- * @param[in,out] deck Pointer to the CardDeck to initialize.
- * 
- */
-void initCardDeck(CardDeck* deck)
-{
-    deck->head = NULL; // No cards yet
-    deck->size = 0;    // Size starts at 0
-}
-
-/**
- * @brief Create a new node for a card.
- *  @details Allocates memory for a CardNode, sets the card value,
- *          and initializes the next pointer to NULL. Exits the
- *          program if memory allocation fails.
- * @param c Card to store.
- * @return CardNode* n Pointer to allocated node.
- */
-static CardNode* createNode(Card c)
-{
-    CardNode* node = malloc(sizeof(CardNode));
-    if (!node) {
-        printf(stderr, "Memory allocation failed in createNode() "); 
-        exit(EXIT_FAILURE); // Fatal error
-    }
-    node->card = c;     // Store card in node
-    node->next = NULL;  // Initially no next node
-    return node;
-}
-
-/**
- * * @brief Add a card to the top of the deck.
- * 
- * @details Inserts the new card at the head of the linked list,
- *          making it the new top card. The deck size is incremented.
- *
- * @param[in,out] deck Pointer to the CardDeck.
- * @param[in] c Card to add.
- */
-void addCardTop(CardDeck* deck, Card c)
-{
-    CardNode* node = createNode(c);
-    node->next = deck->head;  // Insert before old head
-    deck->head = node;        // New head (top of deck)
-    deck->size++;             // Increment deck size
-}
-
-/**
- * @brief Add card at bottom.
- * @details Traverses the linked list to append the card at the end.
- *          If the deck is empty, the new card becomes the head.
- */
-void addCardBottom(CardDeck* deck, Card c)
-{
-    CardNode* node = createNode(c);
-
-    if (!deck->head) {
-        deck->head = node; // First card in empty deck
-    }
-    else {
-        CardNode* cur = deck->head;
-        while (cur->next) // Traverse to last node
-            cur = cur->next;
-        cur->next = node; // Attach new card at end
-    }
-    deck->size++;   // Increment deck size
-}
-
-/**
- * @brief Remove the top card.
- */
-int removeTopCard(CardDeck* deck, Card* out)
-{
-    if (!deck->head)
-        return 0;  // Deck is empty, nothing to remove
-
-    CardNode* old = deck->head;
-    deck->head = old->next;  // Advance head to next card
-
-    if (out)
-        *out = old->card; // Output removed card
-
-    free(old);       // Free old node
-    deck->size--;  // Decrement deck size
-    return 1;    // Success
-}
-
-/**
- * @brief Remove a card at a specific index.
- */
-int removeCardAt(CardDeck* deck, int index, Card* out)
-{
-    if (index < 0 || index >= deck->size || !deck->head)
-        return 0;    // Invalid index or empty deck
-
-    if (index == 0)
-        return removeTopCard(deck, out); // Delegate to removeTopCard
-
-    CardNode* prev = deck->head;
-    for (int i = 0; i < index - 1; i++)
-        prev = prev->next;      // Traverse to node before target
-
-    CardNode* target = prev->next;
-    prev->next = target->next;  // Bypass target node
-
-    if (out)
-        *out = target->card;    // Output removed card
-
-    free(target);     // Free memory
-    deck->size--;       // Update size
-    return 1;       // Success
-}
-
-/**
- * @brief Get number of cards.
- */
-int deckSize(const CardDeck* deck)
-{
-    return deck->size; // Simply return size
-}
-
-/**
- * @brief Check if deck empty.
- */
-int isDeckEmpty(const CardDeck* deck)
-{
-    return (deck->size == 0);// True if no cards
-}
-
-/**
- * @brief Convert deck to array.
- */
-Card* deckToArray(const CardDeck* deck)
-{
-    if (deck->size == 0)
-        return NULL; // Empty deck, nothing to copy
-
-    Card* arr = malloc(sizeof(Card) * deck->size);
-    if (!arr) {
-        fprintf(stderr, "Memory error in deckToArray()");
-        exit(EXIT_FAILURE);
-    }
-
-    CardNode* cur = deck->head;
-    int i = 0;
-    while (cur) {
-        arr[i++] = cur->card;    // Copy card to array
-        cur = cur->next;         // Move to next node
-    }
-    return arr;     // Return array
-}
-
-/**
- * @brief Create a deck with `packs  52` cards.
- */
-void createCardDeck(CardDeck* deck, int packs)
-{
-    initCardDeck(deck);          // Start with empty deck
-    if (packs <= 0)
-        return;                  // No cards to create
-
-    for (int p = 0; p < packs; p++) {
-        for (int s = CLUB; s <= DIAMOND; s++) { // Loop through suits
-            for (int r = TWO; r <= ACE; r++) {  // Loop through ranks
-                Card c;
-                c.suit = (Suit)s;
-                c.rank = (Rank)r;
-                addCardBottom(deck, c);   // Add card to bottom
-            }
-        }
-    }
-}
-
-/**
- * @brief Free all memory used by the deck.
- */
-void freeCardDeck(CardDeck* deck)
-{
-    CardNode* cur = deck->head;
-    while (cur) {
-        CardNode* next = cur->next; // Save next node
-        free(cur);   // Free current node
-        cur = next;   // Move to next
-    }
-
-    deck->head = NULL;  // Reset deck
-    deck->size = 0;
-}
+#include <stdio.h>
+#include <stdlib.h>
+#include "Carddeck.h"
+#include "perf.h"
+#include "shuffle.h"
+
+#if !defined(CARDDECK_RING)
+
+/**
+ * @brief Initialize an empty deck.
+ * @details Sets the deck's head to CARDNODE_NIL, size to 0 and the arena to empty.
+ *          This function must be called before adding any cards.
+ * @param[in,out] deck Pointer to the CardDeck to initialize.
+ * 
+ */
+void initCardDeck(CardDeck* deck)
+{
+    deck->head = CARDNODE_NIL; // No cards yet
+    deck->size = 0;    // Size starts at 0
+
+    deck->arena.chunks = NULL;        // No storage until first node
+    deck->arena.chunkCount = 0;
+    deck->arena.chunkCapacity = 0;
+    deck->arena.used = 0;
+    deck->arena.freeList = CARDNODE_NIL;
+}
+
+/**
+ * @brief Resolve a node index to its slot in the arena.
+ * @details The high bits pick the chunk and the low bits the slot in it.
+ */
+static CardNode* nodeAt(const CardDeck* deck, CardNodeId id)
+{
+    return &deck->arena.chunks[id >> CARDNODE_CHUNK_SHIFT][id & (CARDNODE_CHUNK_SIZE - 1)];
+}
+
+/**
+ * @brief Add one chunk of nodes to the arena.
+ * @details Grows the chunk table geometrically when it is full. Exits the
+ *          program if memory allocation fails.
+ */
+static void growArena(CardNodeArena* arena)
+{
+    if (arena->chunkCount == arena->chunkCapacity) {
+        uint32_t cap = arena->chunkCapacity ? arena->chunkCapacity * 2 : 4;
+        CardNode** chunks = realloc(arena->chunks, cap * sizeof(CardNode*));
+        if (!chunks) {
+            fprintf(stderr, "Memory allocation failed in growArena() ");
+            exit(EXIT_FAILURE); // Fatal error
+        }
+        arena->chunks = chunks;
+        arena->chunkCapacity = cap;
+    }
+
+    CardNode* chunk = malloc(CARDNODE_CHUNK_SIZE * sizeof(CardNode));
+    if (!chunk) {
+        fprintf(stderr, "Memory allocation failed in growArena() ");
+        exit(EXIT_FAILURE); // Fatal error
+    }
+    arena->chunks[arena->chunkCount++] = chunk;
+}
+
+/**
+ * @brief Create a new node for a card.
+ *  @details Takes a node from the arena's free list, or the next unused
+ *          slot (adding a chunk when the last one is full), sets the card
+ *          value, and initializes the next index to CARDNODE_NIL. Exits
+ *          the program once the deck holds CARDNODE_NIL - 1 cards.
+
+ * @param c Card to store.
+ * @return CardNodeId Index of the node.
+ */
+static CardNodeId createNode(CardDeck* deck, Card c)
+{
+    CardNodeArena* arena = &deck->arena;
+    CardNodeId id;
+
+    if (arena->freeList != CARDNODE_NIL) {
+        id = arena->freeList;                  // Reuse a released node
+        arena->freeList = nodeAt(deck, id)->next;
+    }
+    else {
+        if (arena->used == CARDNODE_NIL - 1) { // Every id below the sentinel is taken
+            fprintf(stderr, "Deck too large in createNode(): at most %u cards ", CARDNODE_NIL - 1);
+            exit(EXIT_FAILURE); // Fatal error
+        }
+        if ((uint64_t)arena->used == (uint64_t)arena->chunkCount * CARDNODE_CHUNK_SIZE)
+            growArena(arena);                  // Current chunks are full
+        id = arena->used++;
+    }
+
+    PERF_COUNT(PERF_NODE_ALLOC, 1);
+    CardNode* node = nodeAt(deck, id);
+    node->card = c;     // Store card in node
+    node->next = CARDNODE_NIL;  // Initially no next node
+    return id;
+}
+
+/**
+ * @brief Return a node to the arena's free list.
+ */
+static void releaseNode(CardDeck* deck, CardNodeId id)
+{
+    nodeAt(deck, id)->next = deck->arena.freeList;
+    deck->arena.freeList = id;
+    PERF_COUNT(PERF_NODE_FREE, 1);
+}
+
+/**
+ * * @brief Add a card to the top of the deck.
+ * 
+ * @details Inserts the new card at the head of the linked list,
+ *          making it the new top card. The deck size is incremented.
+ *
+ * @param[in,out] deck Pointer to the CardDeck.
+ * @param[in] c Card to add.
+ */
+void addCardTop(CardDeck* deck, Card c)
+{
+    CardNodeId node = createNode(deck, c);
+    nodeAt(deck, node)->next = deck->head;  // Insert before old head
+    deck->head = node;        // New head (top of deck)
+    deck->size++;             // Increment deck size
+}
+
+/**
+ * @brief Add card at bottom.
+ * @details Traverses the linked list to append the card at the end.
+ *          If the deck is empty, the new card becomes the head.
+ */
+void addCardBottom(CardDeck* deck, Card c)
+{
+    CardNodeId node = createNode(deck, c);
+
+    if (deck->head == CARDNODE_NIL) {
+        deck->head = node; // First card in empty deck
+    }
+    else {
+        CardNode* cur = nodeAt(deck, deck->head);
+        while (cur->next != CARDNODE_NIL) // Traverse to last node
+            cur = nodeAt(deck, cur->next);
+        cur->next = node; // Attach new card at end
+        PERF_COUNT(PERF_NODES_TRAVERSED, deck->size - 1);
+    }
+    deck->size++;   // Increment deck size
+}
+
+/**
+ * @brief Remove the top card.
+ */
+int removeTopCard(CardDeck* deck, Card* out)
+{
+    if (deck->head == CARDNODE_NIL)
+        return 0;  // Deck is empty, nothing to remove
+
+    CardNodeId old = deck->head;
+    CardNode* node = nodeAt(deck, old);
+    deck->head = node->next;  // Advance head to next card
+
+    if (out)
+        *out = node->card; // Output removed card
+
+    releaseNode(deck, old);       // Recycle old node
+    deck->size--;  // Decrement deck size
+    return 1;    // Success
+}
+
+/**
+ * @brief Remove a card at a specific index.
+ */
+int removeCardAt(CardDeck* deck, int64_t index, Card* out)
+{
+    if (index < 0 || index >= deck->size || deck->head == CARDNODE_NIL)
+        return 0;    // Invalid index or empty deck
+
+    if (index == 0)
+        return removeTopCard(deck, out); // Delegate to removeTopCard
+
+    CardNode* prev = nodeAt(deck, deck->head);
+    for (int64_t i = 0; i < index - 1; i++)
+        prev = nodeAt(deck, prev->next);      // Traverse to node before target
+    PERF_COUNT(PERF_NODES_TRAVERSED, index - 1);
+
+    CardNodeId target = prev->next;
+    CardNode* node = nodeAt(deck, target);
+    prev->next = node->next;  // Bypass target node
+
+    if (out)
+        *out = node->card;    // Output removed card
+
+    releaseNode(deck, target);     // Recycle node
+    deck->size--;       // Update size
+    return 1;       // Success
+}
+
+/**
+ * @brief Deal to several hands in one walk.
+ * @details Unlinks the dealt run as a whole: the head jumps past it and its
+ *          nodes go back to the free list as they are read.
+ */
+int dealCards(CardDeck* deck, int players, int perPlayer, int roundRobin, Card* out)
+{
+    int64_t count = (int64_t)players * perPlayer;
+    if (players <= 0 || perPlayer <= 0 || count > deck->size)
+        return 0;    // Nothing to deal or too few cards
+
+    CardNodeId cur = deck->head;
+    for (int64_t i = 0; i < count; i++) {
+        CardNode* node = nodeAt(deck, cur);
+        int64_t slot = roundRobin ? (i % players) * perPlayer + i / players : i;
+        out[slot] = node->card;
+        CardNodeId next = node->next;
+        releaseNode(deck, cur);     // Recycle node
+        cur = next;
+    }
+
+    deck->head = cur;   // First card not dealt
+    deck->size -= count;
+    return 1;
+}
+
+/**
+ * @brief Move all but the top keep cards to the bottom of another deck.
+ * @details Nodes belong to their deck's arena, so they cannot be relinked
+ *          into dst. If dst is empty the decks swap wholesale (list and
+ *          arena) and the kept cards are rebuilt on src; otherwise each
+ *          moved node is copied into dst's arena and released from src.
+ */
+void spliceCards(CardDeck* src, int64_t keep, CardDeck* dst)
+{
+    if (keep < 0)
+        keep = 0;
+    if (keep >= src->size)
+        return;     // Nothing below the kept cards
+
+    if (dst->size == 0) {
+        CardDeck temp = *src;   // Swap decks, arenas included
+        *src = *dst;
+        *dst = temp;
+
+        CardNodeId tail = CARDNODE_NIL;
+        for (int64_t i = 0; i < keep; i++) {
+            Card c;
+            removeTopCard(dst, &c);
+            CardNodeId node = createNode(src, c);
+            if (tail == CARDNODE_NIL)
+                src->head = node;   // First kept card is the top
+            else
+                nodeAt(src, tail)->next = node;
+            tail = node;
+            src->size++;
+        }
+        return;
+    }
+
+    CardNode* last = nodeAt(dst, dst->head);
+    while (last->next != CARDNODE_NIL)
+        last = nodeAt(dst, last->next);     // Bottom of dst
+
+    CardNodeId cur;
+    if (keep == 0) {
+        cur = src->head;
+        src->head = CARDNODE_NIL;
+    }
+    else {
+        CardNode* prev = nodeAt(src, src->head);
+        for (int64_t i = 0; i < keep - 1; i++)
+            prev = nodeAt(src, prev->next);     // Last kept card
+        cur = prev->next;
+        prev->next = CARDNODE_NIL;
+    }
+
+    while (cur != CARDNODE_NIL) {
+        CardNode* node = nodeAt(src, cur);
+        CardNodeId next = node->next;
+        CardNodeId copy = createNode(dst, node->card);
+        last->next = copy;
+        last = nodeAt(dst, copy);
+        releaseNode(src, cur);
+        cur = next;
+    }
+
+    dst->size += src->size - keep;
+    src->size = keep;
+}
+
+/**
+ * @brief Sort the deck.
+ * @details Counts each packed card value in one walk, then overwrites the
+ *          cards in order in a second walk. Nodes keep their links.
+ */
+void sortCardDeck(CardDeck* deck)
+{
+    int64_t hist[CARD_KEYS] = { 0 };
+    PERF_TIMER(start);
+
+    for (CardNodeId cur = deck->head; cur != CARDNODE_NIL; cur = nodeAt(deck, cur)->next)
+        hist[nodeAt(deck, cur)->card.bits]++;   // Histogram pass
+
+    int key = 0;
+    for (CardNodeId cur = deck->head; cur != CARDNODE_NIL; cur = nodeAt(deck, cur)->next) {
+        while (hist[key] == 0)
+            key++;          // Next value still to place
+        hist[key]--;
+        nodeAt(deck, cur)->card.bits = (uint8_t)key;   // Scatter pass
+    }
+    PERF_COUNT(PERF_SORTS, 1);
+    PERF_RECORD(PERF_HIST_SORT, start);
+}
+
+/**
+ * @brief Shuffle the deck.
+ * @details Copies the cards out in one walk, shuffles the array, and
+ *          writes them back in a second walk. Nodes keep their links.
+ */
+void shuffleCardDeck(CardDeck* deck, Rng* rng)
+{
+    Card* cards = deckToArray(deck);
+    if (!cards)
+        return;     // Empty deck
+
+    card_shuffle(cards, deck->size, rng);
+
+    int64_t i = 0;
+    for (CardNodeId cur = deck->head; cur != CARDNODE_NIL; cur = nodeAt(deck, cur)->next)
+        nodeAt(deck, cur)->card = cards[i++];
+
+    free(cards);
+}
+
+/**
+ * @brief Look at the top card.
+ */
+int peekTopCard(const CardDeck* deck, Card* out)
+{
+    if (deck->head == CARDNODE_NIL)
+        return 0;  // Deck is empty
+    *out = nodeAt(deck, deck->head)->card;
+    return 1;
+}
+
+/**
+ * @brief Get number of cards.
+ */
+int64_t deckSize(const CardDeck* deck)
+{
+    return deck->size; // Simply return size
+}
+
+/**
+ * @brief Check if deck empty.
+ */
+int isDeckEmpty(const CardDeck* deck)
+{
+    return (deck->size == 0);// True if no cards
+}
+
+/**
+ * @brief Convert deck to array.
+ */
+Card* deckToArray(const CardDeck* deck)
+{
+    if (deck->size == 0)
+        return NULL; // Empty deck, nothing to copy
+
+    Card* arr = malloc(sizeof(Card) * (size_t)deck->size);
+    if (!arr) {
+        fprintf(stderr, "Memory error in deckToArray()");
+        exit(EXIT_FAILURE);
+    }
+
+    CardNodeId cur = deck->head;
+    int64_t i = 0;
+    while (cur != CARDNODE_NIL) {
+        const CardNode* node = nodeAt(deck, cur);
+        arr[i++] = node->card;    // Copy card to array
+        cur = node->next;         // Move to next node
+    }
+    return arr;     // Return array
+}
+
+/**
+ * @brief Report heap memory held by the deck.
+ * @details Counts whole chunks, including free and never-used slots,
+ *          plus the chunk table itself.
+ */
+size_t deckMemoryUsage(const CardDeck* deck)
+{
+    return (size_t)deck->arena.chunkCount * CARDNODE_CHUNK_SIZE * sizeof(CardNode)
+        + (size_t)deck->arena.chunkCapacity * sizeof(CardNode*);
+}
+
+/**
+ * @brief Create a deck with `packs  52` cards.
+ */
+void createCardDeck(CardDeck* deck, int64_t packs)
+{
+    initCardDeck(deck);          // Start with empty deck
+    if (packs <= 0)
+        return;                  // No cards to create
+    if (packs > (CARDNODE_NIL - 1) / 52) {
+        fprintf(stderr, "Deck of %lld packs is too large in createCardDeck() ", (long long)packs);
+        exit(EXIT_FAILURE); // Node ids would run out
+    }
+
+    for (int64_t p = 0; p < packs; p++) {
+        for (int s = CLUB; s <= DIAMOND; s++) { // Loop through suits
+            for (int r = TWO; r <= ACE; r++) {  // Loop through ranks
+                Card c = card_create((Suit)s, (Rank)r);
+                addCardBottom(deck, c);   // Add card to bottom
+            }
+        }
+    }
+}
+
+/**
+ * @brief Free all memory used by the deck.
+ * @details Releases the arena chunk by chunk; nodes are never freed
+ *          individually.
+ */
+void freeCardDeck(CardDeck* deck)
+{
+    PERF_COUNT(PERF_NODE_FREE, deck->size);     // Nodes still in use go with their chunks
+    for (uint32_t i = 0; i < deck->arena.chunkCount; i++)
+        free(deck->arena.chunks[i]);   // Free whole chunk
+    free(deck->arena.chunks);
+
+    initCardDeck(deck);  // Reset deck
+}
+
+#endif
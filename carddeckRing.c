@@ -0,0 +1,380 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Carddeck.h"
+#include "perf.h"
+#include "shuffle.h"
+
+#if defined(CARDDECK_RING)
+
+/**
+ * @brief Physical slot of the card `i` places from the top.
+ */
+static int64_t slotOf(const CardDeck* deck, int64_t i)
+{
+    return (deck->head + i) & (deck->capacity - 1);
+}
+
+/**
+ * @brief Move the cards into a new buffer of `cap` slots, top card in slot 0.
+ * @details Exits the program if memory allocation fails.
+ */
+static void moveToSlots(CardDeck* deck, int64_t cap)
+{
+    Card* cards = (uint64_t)cap <= SIZE_MAX / sizeof(Card) ? malloc(sizeof(Card) * (size_t)cap) : NULL;
+    if (!cards) {
+        fprintf(stderr, "Memory allocation failed in moveToSlots() ");
+        exit(EXIT_FAILURE); // Fatal error
+    }
+    PERF_COUNT(PERF_DECK_REALLOC, 1);
+
+    if (deck->size > 0) {
+        int64_t first = deck->capacity - deck->head;   // Cards before the wrap
+        if (first > deck->size)
+            first = deck->size;
+        memcpy(cards, deck->cards + deck->head, sizeof(Card) * (size_t)first);
+        memcpy(cards + first, deck->cards, sizeof(Card) * (size_t)(deck->size - first));
+    }
+
+    free(deck->cards);
+    deck->cards = cards;
+    deck->capacity = cap;
+    deck->head = 0;
+}
+
+/**
+ * @brief Make room for at least `needed` cards.
+ * @details Capacity doubles until it fits; the old contents are unwrapped
+ *          into the new buffer so the top card lands in slot 0.
+ */
+static void reserveSlots(CardDeck* deck, int64_t needed)
+{
+    if (needed <= deck->capacity)
+        return;    // Already big enough
+
+    int64_t cap = deck->capacity ? deck->capacity : 8;
+    while (cap < needed)
+        cap *= 2;
+    moveToSlots(deck, cap);
+}
+
+/**
+ * @brief Shift `n` cards starting `from` places down one place toward the bottom.
+ * @details Works back to front in runs that do not cross the wrap point,
+ *          so it is at most three memmoves.
+ */
+static void shiftTowardBottom(CardDeck* deck, int64_t from, int64_t n)
+{
+    while (n > 0) {
+        int64_t srcLast = slotOf(deck, from + n - 1);
+        int64_t dstLast = slotOf(deck, from + n);
+        int64_t len = n;
+        if (len > srcLast + 1)
+            len = srcLast + 1;    // Stop at the start of the buffer
+        if (len > dstLast + 1)
+            len = dstLast + 1;
+        memmove(deck->cards + dstLast - len + 1, deck->cards + srcLast - len + 1, sizeof(Card) * (size_t)len);
+        n -= len;
+    }
+}
+
+/**
+ * @brief Shift `n` cards starting `from` places down one place toward the top.
+ * @details Works front to back in runs that do not cross the wrap point,
+ *          so it is at most three memmoves.
+ */
+static void shiftTowardTop(CardDeck* deck, int64_t from, int64_t n)
+{
+    while (n > 0) {
+        int64_t src = slotOf(deck, from);
+        int64_t dst = slotOf(deck, from - 1);
+        int64_t len = n;
+        if (len > deck->capacity - src)
+            len = deck->capacity - src;    // Stop at the end of the buffer
+        if (len > deck->capacity - dst)
+            len = deck->capacity - dst;
+        memmove(deck->cards + dst, deck->cards + src, sizeof(Card) * (size_t)len);
+        from += len;
+        n -= len;
+    }
+}
+
+/**
+ * @brief Initialize an empty deck.
+ * @details No storage is allocated until the first card is added.
+ * @param[in,out] deck Pointer to the CardDeck to initialize.
+ */
+void initCardDeck(CardDeck* deck)
+{
+    deck->cards = NULL;
+    deck->head = 0;
+    deck->size = 0;
+    deck->capacity = 0;
+}
+
+/**
+ * @brief Add a card to the top of the deck in O(1).
+ */
+void addCardTop(CardDeck* deck, Card c)
+{
+    reserveSlots(deck, deck->size + 1);
+    deck->head = (deck->head - 1) & (deck->capacity - 1);  // Step back, wrapping
+    deck->cards[deck->head] = c;
+    deck->size++;
+}
+
+/**
+ * @brief Add a card to the bottom of the deck in O(1).
+ */
+void addCardBottom(CardDeck* deck, Card c)
+{
+    reserveSlots(deck, deck->size + 1);
+    deck->cards[slotOf(deck, deck->size)] = c;
+    deck->size++;
+}
+
+/**
+ * @brief Remove the top card in O(1).
+ */
+int removeTopCard(CardDeck* deck, Card* out)
+{
+    if (deck->size == 0)
+        return 0;  // Deck is empty, nothing to remove
+
+    if (out)
+        *out = deck->cards[deck->head]; // Output removed card
+
+    deck->head = (deck->head + 1) & (deck->capacity - 1);
+    deck->size--;
+    return 1;
+}
+
+/**
+ * @brief Remove a card at a specific index.
+ * @details Closes the gap by moving whichever side of the index is shorter.
+ */
+int removeCardAt(CardDeck* deck, int64_t index, Card* out)
+{
+    if (index < 0 || index >= deck->size)
+        return 0;    // Invalid index or empty deck
+
+    if (out)
+        *out = deck->cards[slotOf(deck, index)];    // Output removed card
+
+    if (index < deck->size - 1 - index) {
+        shiftTowardBottom(deck, 0, index);    // Cards above slide down
+        deck->head = (deck->head + 1) & (deck->capacity - 1);
+    }
+    else {
+        shiftTowardTop(deck, index + 1, deck->size - 1 - index);    // Cards below slide up
+    }
+
+    deck->size--;
+    return 1;
+}
+
+/**
+ * @brief Deal to several hands.
+ * @details Block order copies the dealt run with at most two memcpy calls;
+ *          round-robin order reads each slot once. Either way the head just
+ *          moves past the run.
+ */
+int dealCards(CardDeck* deck, int players, int perPlayer, int roundRobin, Card* out)
+{
+    int64_t count = (int64_t)players * perPlayer;
+    if (players <= 0 || perPlayer <= 0 || count > deck->size)
+        return 0;    // Nothing to deal or too few cards
+
+    if (roundRobin) {
+        for (int64_t i = 0; i < count; i++)
+            out[(i % players) * perPlayer + i / players] = deck->cards[slotOf(deck, i)];
+    }
+    else {
+        int64_t first = deck->capacity - deck->head;   // Slots before the wrap
+        if (first > count)
+            first = count;
+        memcpy(out, deck->cards + deck->head, sizeof(Card) * (size_t)first);
+        memcpy(out + first, deck->cards, sizeof(Card) * (size_t)(count - first));
+    }
+
+    deck->head = slotOf(deck, count);
+    deck->size -= count;
+    return 1;
+}
+
+/**
+ * @brief Move all but the top keep cards to the bottom of another deck.
+ * @details If dst is empty the two buffers are swapped and the kept cards
+ *          are pushed back onto src; otherwise the moved cards are copied
+ *          after dst's bottom card in runs that cross neither buffer's wrap
+ *          point, so it is at most three memcpy calls.
+ */
+void spliceCards(CardDeck* src, int64_t keep, CardDeck* dst)
+{
+    if (keep < 0)
+        keep = 0;
+    if (keep >= src->size)
+        return;     // Nothing below the kept cards
+
+    if (dst->size == 0) {
+        CardDeck temp = *src;   // Swap buffers
+        *src = *dst;
+        *dst = temp;
+
+        for (int64_t i = keep - 1; i >= 0; i--)
+            addCardTop(src, dst->cards[slotOf(dst, i)]);    // Bottom kept card first
+        dst->head = slotOf(dst, keep);
+        dst->size -= keep;
+        return;
+    }
+
+    int64_t moved = src->size - keep;
+    reserveSlots(dst, dst->size + moved);
+    for (int64_t done = 0; done < moved; ) {
+        int64_t from = slotOf(src, keep + done);
+        int64_t to = slotOf(dst, dst->size + done);
+        int64_t run = moved - done;
+        if (run > src->capacity - from)
+            run = src->capacity - from;    // Stop at src's wrap
+        if (run > dst->capacity - to)
+            run = dst->capacity - to;      // Stop at dst's wrap
+        memcpy(dst->cards + to, src->cards + from, sizeof(Card) * (size_t)run);
+        done += run;
+    }
+    dst->size += moved;
+
+    src->size = keep;
+}
+
+/**
+ * @brief Sort the deck.
+ * @details Sorts in place when the cards do not wrap; otherwise counts
+ *          each value and rewrites the cards slot by slot.
+ */
+void sortCardDeck(CardDeck* deck)
+{
+    if (deck->head + deck->size <= deck->capacity) {
+        card_sort(deck->cards + deck->head, deck->size);    // One contiguous run
+        return;
+    }
+
+    int64_t hist[CARD_KEYS] = { 0 };
+    PERF_TIMER(start);
+
+    for (int64_t i = 0; i < deck->size; i++)
+        hist[deck->cards[slotOf(deck, i)].bits]++;   // Histogram pass
+
+    int key = 0;
+    for (int64_t i = 0; i < deck->size; i++) {
+        while (hist[key] == 0)
+            key++;          // Next value still to place
+        hist[key]--;
+        deck->cards[slotOf(deck, i)].bits = (uint8_t)key;   // Scatter pass
+    }
+    PERF_COUNT(PERF_SORTS, 1);
+    PERF_RECORD(PERF_HIST_SORT, start);
+}
+
+/**
+ * @brief Shuffle the deck in place.
+ * @details A deck that wraps past the end of its buffer is unwrapped first,
+ *          so the cards are one run that card_shuffle() can take whole.
+ */
+void shuffleCardDeck(CardDeck* deck, Rng* rng)
+{
+    if (deck->head + deck->size > deck->capacity)
+        moveToSlots(deck, deck->capacity);
+    card_shuffle(deck->cards + deck->head, deck->size, rng);
+}
+
+/**
+ * @brief Look at the top card.
+ */
+int peekTopCard(const CardDeck* deck, Card* out)
+{
+    if (deck->size == 0)
+        return 0;  // Deck is empty
+    *out = deck->cards[deck->head];
+    return 1;
+}
+
+/**
+ * @brief Get number of cards.
+ */
+int64_t deckSize(const CardDeck* deck)
+{
+    return deck->size;
+}
+
+/**
+ * @brief Check if deck empty.
+ */
+int isDeckEmpty(const CardDeck* deck)
+{
+    return (deck->size == 0);
+}
+
+/**
+ * @brief Convert deck to array with at most two copies.
+ */
+Card* deckToArray(const CardDeck* deck)
+{
+    if (deck->size == 0)
+        return NULL; // Empty deck, nothing to copy
+
+    Card* arr = malloc(sizeof(Card) * (size_t)deck->size);
+    if (!arr) {
+        fprintf(stderr, "Memory error in deckToArray()");
+        exit(EXIT_FAILURE);
+    }
+
+    int64_t first = deck->capacity - deck->head;   // Cards before the wrap
+    if (first > deck->size)
+        first = deck->size;
+    memcpy(arr, deck->cards + deck->head, sizeof(Card) * (size_t)first);
+    memcpy(arr + first, deck->cards, sizeof(Card) * (size_t)(deck->size - first));
+    return arr;
+}
+
+/**
+ * @brief Report heap memory held by the ring buffer.
+ */
+size_t deckMemoryUsage(const CardDeck* deck)
+{
+    return (size_t)deck->capacity * sizeof(Card);
+}
+
+/**
+ * @brief Create a deck with `packs x 52` cards.
+ * @details Allocates once up front and writes the cards in order.
+ */
+void createCardDeck(CardDeck* deck, int64_t packs)
+{
+    initCardDeck(deck);          // Start with empty deck
+    if (packs <= 0)
+        return;                  // No cards to create
+    if (packs > INT64_MAX / 104) {
+        fprintf(stderr, "Deck of %lld packs is too large in createCardDeck() ", (long long)packs);
+        exit(EXIT_FAILURE); // Capacity would overflow when rounded up
+    }
+
+    reserveSlots(deck, packs * 52);
+    for (int64_t p = 0; p < packs; p++) {
+        for (int s = CLUB; s <= DIAMOND; s++) { // Loop through suits
+            for (int r = TWO; r <= ACE; r++) {  // Loop through ranks
+                deck->cards[deck->size++] = card_create((Suit)s, (Rank)r);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Free all memory used by the deck.
+ */
+void freeCardDeck(CardDeck* deck)
+{
+    free(deck->cards);
+    initCardDeck(deck);  // Reset deck
+}
+
+#endif
@@ -0,0 +1,260 @@
+/**
+* @file deck.h
+* @brief One deck API (carddeck_*) over whichever backend the build selects.
+*
+* Backends, chosen at compile time; compile exactly the matching source:
+*   (default)                         dynamic array, cardDeck.c
+*   DECK_BACKEND_LIST                 linked list in a slab arena, carddeck.c
+*   DECK_BACKEND_LIST + CARDDECK_RING ring-buffer deque, carddeckRing.c
+*
+* Every wrapper is static inline, so there is no dispatch cost. Semantics
+* are the same for all backends: position 0 is the top card, pop_top and
+* peek_top use the top, a fresh deck deals Club-Two first, and a sorted
+* deck has its lowest card on top.
+*
+* Dealing: carddeck_deal() copies N hands of K cards off the top in one
+* call; carddeck_deal_views() deals in block order and returns each hand as
+* a CardView. On the array backend each view points straight into the
+* deck's storage (no copy); the other backends fill a caller scratch array.
+*
+* Moving piles: carddeck_swap() trades two decks' storage in O(1), and
+* carddeck_splice_below() moves everything under the top N cards of one
+* deck to the bottom of another; into an empty deck that is a swap plus
+* copying N cards back.
+*
+* Sizes, positions and pack counts are 64-bit, so a deck is limited by
+* memory rather than by int; the list backend also caps out at 2^32 - 1
+* cards because of its 32-bit node ids.
+*/
+#ifndef DECK_H
+#define DECK_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "Card.h"
+#include "rng.h"
+
+/* how carddeck_deal() assigns the top cards to hands */
+typedef enum {
+	DEAL_ROUND_ROBIN, // One card to each player in turn, like a dealer
+	DEAL_BLOCK // Each player gets the next K cards in one run
+} DealOrder;
+
+/* read-only run of cards, e.g. one player's share of a deal */
+typedef struct {
+	const Card* cards;
+	int64_t size;
+} CardView;
+
+
+#if defined(CARDDECK_RING) && !defined(DECK_BACKEND_LIST)
+#define DECK_BACKEND_LIST
+#endif
+
+#if defined(DECK_BACKEND_LIST)
+
+#include "Carddeck.h"
+
+#if defined(CARDDECK_RING)
+#define DECK_BACKEND_NAME "ring" // Label for benchmarks and logs
+#else
+#define DECK_BACKEND_NAME "list" // Label for benchmarks and logs
+#endif
+
+
+static inline void carddeck_init(CardDeck* deck) { initCardDeck(deck); }
+static inline void carddeck_init_packs(CardDeck* deck, int64_t packs) { createCardDeck(deck, packs); }
+static inline void carddeck_free(CardDeck* deck) { freeCardDeck(deck); }
+static inline int64_t carddeck_size(const CardDeck* deck) { return deckSize(deck); }
+static inline int carddeck_is_empty(const CardDeck* deck) { return isDeckEmpty(deck); }
+static inline void carddeck_push_top(CardDeck* deck, Card c) { addCardTop(deck, c); }
+static inline void carddeck_push_bottom(CardDeck* deck, Card c) { addCardBottom(deck, c); }
+static inline int carddeck_pop_top(CardDeck* deck, Card* out) { return removeTopCard(deck, out); }
+static inline int carddeck_peek_top(const CardDeck* deck, Card* out) { return peekTopCard(deck, out); }
+static inline int carddeck_remove_at(CardDeck* deck, int64_t index, Card* out) { return removeCardAt(deck, index, out); }
+static inline void carddeck_sort(CardDeck* deck) { sortCardDeck(deck); }
+static inline void carddeck_shuffle(CardDeck* deck, Rng* rng) { shuffleCardDeck(deck, rng); }
+static inline Card* carddeck_to_array(const CardDeck* deck) { return deckToArray(deck); }
+
+static inline void carddeck_splice_below(CardDeck* src, int64_t keep, CardDeck* dst) { spliceCards(src, keep, dst); }
+
+static inline int carddeck_deal(CardDeck* deck, int players, int per_player, DealOrder order, Card* out)
+{
+	return dealCards(deck, players, per_player, order == DEAL_ROUND_ROBIN, out);
+}
+
+/* block deal into scratch (players * per_player cards); views point into it */
+static inline int carddeck_deal_views(CardDeck* deck, int players, int per_player, CardView* views, Card* scratch)
+{
+	if (!dealCards(deck, players, per_player, 0, scratch))
+		return 0;
+	for (int p = 0; p < players; p++) {
+		views[p].cards = scratch + p * per_player;
+		views[p].size = per_player;
+	}
+	return 1;
+}
+
+#else
+
+#include "cardDeck.h"
+
+#define DECK_BACKEND_NAME "array" // Label for benchmarks and logs
+
+/*
+* The array keeps its top card at the end, so position i from the top is
+* cards[size - 1 - i].
+*/
+
+static inline void carddeck_init(CardDeck* deck) { initDeck(deck); }
+static inline void carddeck_init_packs(CardDeck* deck, int64_t packs) { *deck = createDeck(packs); }
+static inline void carddeck_free(CardDeck* deck) { freeDeck(deck); }
+static inline int64_t carddeck_size(const CardDeck* deck) { return deck->size; }
+static inline int carddeck_is_empty(const CardDeck* deck) { return deck->size == 0; }
+static inline void carddeck_push_top(CardDeck* deck, Card c) { addCard(deck, c); }
+static inline void carddeck_shuffle(CardDeck* deck, Rng* rng) { shuffleDeck(deck, rng); }
+
+static inline void carddeck_push_bottom(CardDeck* deck, Card c)
+{
+	if (!reserveDeck(deck, deck->size + 1)) {
+		fprintf(stderr, "Memory allocation failed in carddeck_push_bottom() ");
+		exit(EXIT_FAILURE);
+	}
+	deck->size++; // Open a slot at the bottom
+	memmove(deck->cards + 1, deck->cards, sizeof(Card) * (size_t)(deck->size - 1));
+	deck->cards[0] = c;
+}
+
+static inline int carddeck_pop_top(CardDeck* deck, Card* out)
+{
+	if (deck->size == 0)
+		return 0;
+	Card top = removeTopCard(deck);
+	if (out)
+		*out = top;
+	return 1;
+}
+
+static inline int carddeck_peek_top(const CardDeck* deck, Card* out)
+{
+	if (deck->size == 0)
+		return 0;
+	*out = deck->cards[deck->size - 1];
+	return 1;
+}
+
+static inline int carddeck_remove_at(CardDeck* deck, int64_t index, Card* out)
+{
+	if (index < 0 || index >= deck->size)
+		return 0;
+	int64_t slot = deck->size - 1 - index;
+	if (out)
+		*out = deck->cards[slot];
+	memmove(deck->cards + slot, deck->cards + slot + 1, sizeof(Card) * (size_t)index);
+	deck->size--;
+	return 1;
+}
+
+static inline void carddeck_sort(CardDeck* deck) { sortDeck(deck); }
+
+
+static inline Card* carddeck_to_array(const CardDeck* deck)
+{
+	if (deck->size == 0)
+		return NULL;
+	Card* arr = (Card*)malloc(sizeof(Card) * (size_t)deck->size);
+	if (!arr) {
+		fprintf(stderr, "Memory allocation failed in carddeck_to_array() ");
+		exit(EXIT_FAILURE); // As the list and ring decks do
+	}
+	for (int64_t i = 0; i < deck->size; i++)
+		arr[i] = deck->cards[deck->size - 1 - i];
+	return arr;
+}
+
+static inline int carddeck_deal(CardDeck* deck, int players, int per_player, DealOrder order, Card* out)
+{
+	int64_t count = (int64_t)players * per_player;
+	if (players <= 0 || per_player <= 0 || count > deck->size)
+		return 0;
+	if (order == DEAL_BLOCK) {
+		// The dealt run is the top count cards, bottom first: copy it, then flip it
+		memcpy(out, deck->cards + deck->size - count, sizeof(Card) * (size_t)count);
+		for (int64_t i = 0, j = count - 1; i < j; i++, j--) {
+			Card temp = out[i];
+			out[i] = out[j];
+			out[j] = temp;
+		}
+	}
+	else {
+		const Card* top = deck->cards + deck->size - 1; // Position i is top[-i]
+		for (int64_t i = 0; i < count; i++)
+			out[(i % players) * per_player + i / players] = top[-i];
+	}
+	deck->size -= count;
+	return 1;
+}
+
+/*
+* The bottom of the array is index 0, so the moved run is cards[0..moved-1]
+* and it goes in front of dst's cards.
+*/
+static inline void carddeck_splice_below(CardDeck* src, int64_t keep, CardDeck* dst)
+{
+	if (keep < 0)
+		keep = 0;
+	int64_t moved = src->size - keep;
+	if (moved <= 0)
+		return;
+
+	if (dst->size == 0) {
+		CardDeck temp = *src; // Trade buffers, then hand the kept top back
+		*src = *dst;
+		*dst = temp;
+		addCards(src, dst->cards + dst->size - keep, keep);
+		dst->size -= keep;
+		return;
+	}
+
+	if (!reserveDeck(dst, dst->size + moved)) {
+		fprintf(stderr, "Memory allocation failed in carddeck_splice_below() ");
+		exit(EXIT_FAILURE);
+	}
+	memmove(dst->cards + moved, dst->cards, sizeof(Card) * (size_t)dst->size);
+	memcpy(dst->cards, src->cards, sizeof(Card) * (size_t)moved);
+	memmove(src->cards, src->cards + moved, sizeof(Card) * (size_t)keep);
+	dst->size += moved;
+	src->size = keep;
+}
+
+/*
+* Block deal without copying: the dealt cards stay in the deck's buffer
+* above the new size, and views[p] covers player p's run (bottom-to-top,
+* so not in deal order; hands sort on receipt anyway). The views stay
+* valid until the next card is added to the deck. scratch is unused.
+*/
+static inline int carddeck_deal_views(CardDeck* deck, int players, int per_player, CardView* views, Card* scratch)
+{
+	(void)scratch;
+	int64_t count = (int64_t)players * per_player;
+	if (players <= 0 || per_player <= 0 || count > deck->size)
+		return 0;
+	for (int p = 0; p < players; p++) {
+		views[p].cards = deck->cards + deck->size - (p + 1) * per_player;
+		views[p].size = per_player;
+	}
+	deck->size -= count;
+	return 1;
+}
+
+#endif
+
+/* trade the contents of two decks without touching any card */
+static inline void carddeck_swap(CardDeck* a, CardDeck* b)
+{
+	CardDeck temp = *a;
+	*a = *b;
+	*b = temp;
+}
+
+#endif
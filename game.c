@@ -0,0 +1,447 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "game.h"
+#include "perf.h"
+
+/* start a player with an empty hand */
+void player_init(Player* p, int64_t packs)
+{
+    hand_init(&p->hand);
+    p->set = CARDSET_EMPTY;
+    handindex_init(&p->index);
+    p->use_set = (packs == 1);
+    p->use_index = (packs > 1);
+}
+
+/* put a card in the player's hand, keeping order and mirrors */
+void player_take(Player* p, Card c)
+{
+    hand_insert(&p->hand, c);
+    if (p->use_set)
+        cardset_insert(&p->set, c);
+    if (p->use_index)
+        handindex_add(&p->index, c);
+}
+
+/* put a whole dealt hand in at once: one copy and one sort */
+void player_take_all(Player* p, CardView cards)
+{
+    hand_insert_all(&p->hand, cards.cards, cards.size);
+    if (p->use_set)
+        p->set = cardset_union(p->set, cardset_from_array(cards.cards, cards.size));
+    if (p->use_index) {
+        for (int64_t i = 0; i < cards.size; i++)
+            handindex_add(&p->index, cards.cards[i]);
+    }
+}
+
+/* take the card at index out of the player's hand */
+Card player_give(Player* p, int index)
+{
+    Card c;
+    hand_remove_at(&p->hand, index, &c);
+    if (p->use_set)
+        cardset_remove(&p->set, c);
+    if (p->use_index)
+        handindex_remove(&p->index, c);
+    return c;
+}
+
+ /* pause function */
+void wait_for_enter(void)
+{
+    printf("Press ENTER to continue...");
+    while (getchar() != '\n')
+        ;
+}
+
+/* display a player's hand */
+void print_player_hand(int player_num, const Hand* player)
+{
+    printf("Player %d's cards:\n", player_num);
+    deck_write(player->cards, player->size, stdout);
+    printf("\n");
+}
+
+/* first matching card index, or -1 */
+int find_matching_card(Player* p, Card top)
+{
+    if (p->use_set) {
+        /* one AND finds every match; sorted hand index = cards below it */
+        Card match;
+        if (!cardset_first_match(p->set, top, &match))
+            return -1;
+        return cardset_rank_of(p->set, match);
+    }
+
+    if (p->use_index) {
+        /* count matrix gives the first match and its sorted position */
+        Card match;
+        if (!handindex_first_playable(&p->index, top, &match))
+            return -1;
+        return (int)handindex_position(&p->index, match);
+    }
+
+    return -1;  /* no packs, so no cards */
+}
+
+
+/* move played card to played deck and display */
+void play_card(Game* g, int player_num, int index)
+{
+    Player* player = &g->players[player_num - 1];
+    Card c = player_give(player, index);
+    Card under;
+
+    if (carddeck_peek_top(&g->played, &under))
+        zobrist_add(&g->zobrist, ZOBRIST_PLAYED, under);
+    zobrist_remove(&g->zobrist, ZOBRIST_HAND1 + player_num - 1, c);
+    carddeck_push_top(&g->played, c);
+
+    if (g->verbosity >= VERBOSITY_TURNS) {
+        printf("Player %d played %s\n", player_num, card_to_string(c));
+        print_player_hand(player_num, &player->hand);
+    }
+}
+
+/* 1 if there is nothing left to draw */
+int hidden_is_empty(const Game* g)
+{
+    return g->use_shoe ? shoe_is_empty(&g->shoe) : carddeck_is_empty(&g->hidden);
+}
+
+/* cards left to draw */
+int64_t hidden_size(const Game* g)
+{
+    return g->use_shoe ? (int64_t)shoe_size(&g->shoe) : carddeck_size(&g->hidden);
+}
+
+/* top hidden card, or a random one from the shoe; 0 if none is left */
+static int hidden_draw(Game* g, Card* out)
+{
+    if (g->use_shoe)
+        return shoe_draw(&g->shoe, &g->rng, out);
+    return carddeck_pop_top(&g->hidden, out);
+}
+
+/* handle drawing a card; returns 0 if there was nothing to draw */
+int draw_card(Game* g, int player_num)
+{
+    Player* player = &g->players[player_num - 1];
+    Card drawn;
+
+    if (!hidden_draw(g, &drawn))
+        return 0;
+
+    if (g->verbosity >= VERBOSITY_TURNS)
+        printf("Player %d picks %s from hidden deck.\n", player_num, card_to_string(drawn));
+
+    /* goes straight into its sorted slot; no re-sort */
+    player_take(player, drawn);
+    zobrist_move(&g->zobrist, ZOBRIST_HIDDEN, ZOBRIST_HAND1 + player_num - 1, drawn);
+
+    if (g->verbosity >= VERBOSITY_TURNS)
+        print_player_hand(player_num, &player->hand);
+    return 1;
+}
+
+/* refill hidden deck when empty; returns 1 if it was refilled */
+int refill_if_needed(Game* g)
+{
+    CardDeck* hidden = &g->hidden;
+    CardDeck* played = &g->played;
+
+    if (!hidden_is_empty(g) || carddeck_size(played) < 2)
+        return 0;
+
+    if (g->verbosity >= VERBOSITY_TURNS)
+        printf("\n*** Hidden deck empty — refilling and shuffling ***\n");
+    PERF_COUNT(PERF_REFILL_CARDS, carddeck_size(played) - 1);
+    zobrist_refill(&g->zobrist);
+
+    if (g->use_shoe) {
+        /* a shoe needs no shuffle: the cards just go back into the counts */
+        Card c;
+        carddeck_splice_below(played, 1, hidden);
+        while (carddeck_pop_top(hidden, &c))
+            shoe_add(&g->shoe, c, 1);
+        return 1;
+    }
+
+    /* everything under the last played card becomes the new hidden deck */
+    carddeck_splice_below(played, 1, hidden);
+    carddeck_shuffle(hidden, &g->rng);
+    return 1;
+}
+
+/* deal per_player cards to each player off the hidden deck */
+void deal_hands(Game* g, int per_player)
+{
+    CardView views[2];
+    Card local[64];     /* scratch for backends that cannot lend views */
+    Card* scratch = local;
+
+    if (2 * per_player > 64) {
+        scratch = malloc(sizeof(Card) * 2 * per_player);
+        if (!scratch) {
+            fprintf(stderr, "Memory allocation failed in deal_hands()\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    int dealt;
+    if (g->use_shoe) {
+        dealt = shoe_deal(&g->shoe, &g->rng, scratch, 2 * per_player);
+        views[0] = (CardView){ scratch, per_player };
+        views[1] = (CardView){ scratch + per_player, per_player };
+    }
+    else
+        dealt = carddeck_deal_views(&g->hidden, 2, per_player, views, scratch);
+
+    if (dealt) {
+        for (int p = 0; p < 2; p++) {
+            player_take_all(&g->players[p], views[p]);
+            for (int64_t i = 0; i < views[p].size; i++)
+                zobrist_move(&g->zobrist, ZOBRIST_HIDDEN, ZOBRIST_HAND1 + p, views[p].cards[i]);
+        }
+    }
+
+    if (scratch != local)
+        free(scratch);
+}
+
+/* pause between steps in interactive mode only */
+static void maybe_wait(const Game* g)
+{
+    if (g->interactive)
+        wait_for_enter();
+}
+
+/* ---------------- MAIN GAME LOOP ---------------- */
+
+/* set up a game: fresh shuffled deck (or full shoe), 8 cards each, first card face up */
+void game_start(Game* g, int64_t packs)
+{
+    carddeck_init(&g->hidden);
+    carddeck_init(&g->played);
+    player_init(&g->players[0], packs);
+    player_init(&g->players[1], packs);
+    g->packs = packs;
+    g->turn = 1;
+    g->passes = 0;
+    g->winner = 0;
+    g->over = 0;
+    g->last_move = MOVE_PASS;
+    g->turns = 0;
+    g->refills = 0;
+    zobrist_reset(&g->zobrist, packs);
+
+    if (g->use_shoe) {
+        /* counts only; every draw is already random */
+        shoe_init(&g->shoe, (uint64_t)packs);
+    }
+    else {
+        /* create ordered deck */
+        carddeck_init_packs(&g->hidden, packs);
+
+        /* shuffle */
+        if (g->verbosity >= VERBOSITY_TURNS)
+            printf("\nShuffling deck...\n");
+        carddeck_shuffle(&g->hidden, &g->rng);
+    }
+
+    /* deal 8 cards each */
+    if (g->verbosity >= VERBOSITY_TURNS)
+        printf("Dealing cards...\n");
+    deal_hands(g, 8);
+
+    /* print hands */
+    if (g->verbosity >= VERBOSITY_TURNS) {
+        print_player_hand(1, &g->players[0].hand);
+        print_player_hand(2, &g->players[1].hand);
+    }
+
+    maybe_wait(g);
+
+    /* start game */
+    if (g->verbosity >= VERBOSITY_TURNS)
+        printf("Starting game...\n");
+
+    /* flip top card to start played pile; with nothing left to flip there
+     * is no game to play */
+    Card top;
+    if (!hidden_draw(g, &top)) {
+        fprintf(stderr, "Not enough cards to start a game.\n");
+        g->over = 1;
+        return;
+    }
+    zobrist_remove(&g->zobrist, ZOBRIST_HIDDEN, top);
+
+    carddeck_push_top(&g->played, top);
+    if (g->verbosity >= VERBOSITY_TURNS)
+        printf("Initial card: %s\n\n", card_to_string(top));
+
+    maybe_wait(g);
+}
+
+/* the built-in policy: first playable card, else draw, else pass */
+int game_choose_move(Game* g)
+{
+    Card top;
+    carddeck_peek_top(&g->played, &top);
+
+    int index = find_matching_card(&g->players[g->turn - 1], top);
+    if (index >= 0)
+        return index;
+    return hidden_is_empty(g) ? MOVE_PASS : MOVE_DRAW;
+}
+
+/* a play must match the top card; draw and pass only when nothing does */
+static int move_is_legal(Game* g, int move)
+{
+    Player* p = &g->players[g->turn - 1];
+    Card top;
+    carddeck_peek_top(&g->played, &top);
+
+    if (move >= 0)
+        return move < p->hand.size && card_matches(p->hand.cards[move], top);
+    if (find_matching_card(p, top) >= 0)
+        return 0;
+    if (move == MOVE_DRAW)
+        return !hidden_is_empty(g);
+    return move == MOVE_PASS && hidden_is_empty(g);
+}
+
+/* carry out a move already known to be legal; 1 if the game goes on */
+static int do_turn(Game* g, int move)
+{
+    int turn = g->turn;
+    Player* p = &g->players[turn - 1];
+
+    g->turns++;
+    g->last_move = move;
+    if (g->verbosity >= VERBOSITY_TURNS)
+        printf("\n--- Player %d's turn ---\n", turn);
+
+    if (move >= 0) {
+        play_card(g, turn, move);
+        g->passes = 0;
+    }
+    else {
+        if (g->verbosity >= VERBOSITY_TURNS)
+            printf("Player %d cannot play.\n", turn);
+        if (move == MOVE_DRAW && draw_card(g, turn))
+            g->passes = 0;
+        else if (++g->passes == 2) {
+            g->over = 1;    /* nobody can play or draw: stalemate */
+            return 0;
+        }
+    }
+
+    if (p->hand.size == 0) {
+        if (g->verbosity >= VERBOSITY_TURNS)
+            printf("Player %d wins!\n", turn);
+        g->winner = turn;
+        g->over = 1;
+        return 0;
+    }
+
+    g->refills += refill_if_needed(g);
+
+    maybe_wait(g);
+    g->turn = (turn == 1 ? 2 : 1);
+    return 1;
+}
+
+/* do_turn() with the turn counted and timed */
+static int do_move(Game* g, int move)
+{
+    PERF_TIMER(start);
+    int more = do_turn(g, move);
+    PERF_COUNT(PERF_TURNS, 1);
+    PERF_RECORD(PERF_HIST_TURN, start);
+    return more;
+}
+
+/* play one given move for g->turn; 1 if the game goes on, 0 if over, -1 if illegal */
+int game_apply(Game* g, int move)
+{
+    if (g->over)
+        return 0;
+    if (!move_is_legal(g, move))
+        return -1;
+    return do_move(g, move);
+}
+
+/* play one turn with the built-in policy; returns 0 once the game is over */
+int game_step(Game* g)
+{
+    if (g->over)
+        return 0;
+    return do_move(g, game_choose_move(g));
+}
+
+/* O(1): the sums are already current */
+uint64_t game_hash(const Game* g)
+{
+    Card top = { 0 };
+    carddeck_peek_top(&g->played, &top);
+    return zobrist_hash(&g->zobrist, top, g->turn, g->passes);
+}
+
+/* add every card of a deck to a zone, less the top card if skip_top */
+static void rehash_deck(Zobrist* z, int zone, const CardDeck* deck, int skip_top)
+{
+    int64_t n = carddeck_size(deck);
+    Card* cards = carddeck_to_array(deck);
+
+    if (!cards && n > 0) {
+        fprintf(stderr, "Memory allocation failed in game_rehash()\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int64_t i = skip_top ? 1 : 0; i < n; i++)
+        zobrist_add(z, zone, cards[i]);
+    free(cards);
+}
+
+/* Sum every zone from scratch */
+void game_rehash(Game* g)
+{
+    Zobrist* z = &g->zobrist;
+
+    for (int i = 0; i < ZOBRIST_ZONES; i++)
+        z->sum[i] = 0;
+    for (int p = 0; p < 2; p++) {
+        const Hand* h = &g->players[p].hand;
+        for (int64_t i = 0; i < h->size; i++)
+            zobrist_add(z, ZOBRIST_HAND1 + p, h->cards[i]);
+    }
+    if (g->use_shoe) {
+        for (int k = 0; k < SHOE_KINDS; k++) {
+            Card c = card_create((Suit)(k / 13), (Rank)(TWO + k % 13));
+            z->sum[ZOBRIST_HIDDEN] += zobrist_keys[c.bits] * g->shoe.count[k];
+        }
+    }
+    else
+        rehash_deck(z, ZOBRIST_HIDDEN, &g->hidden, 0);
+    rehash_deck(z, ZOBRIST_PLAYED, &g->played, 1);
+}
+
+/* release the decks and hands */
+void game_free(Game* g)
+{
+    carddeck_free(&g->hidden);
+    carddeck_free(&g->played);
+    hand_free(&g->players[0].hand);
+    hand_free(&g->players[1].hand);
+}
+
+/* play one full game; returns the winner (1 or 2), or 0 if it stalls */
+int play_game(Game* g, int64_t packs)
+{
+    game_start(g, packs);
+    while (game_step(g))
+        ;
+    game_free(g);
+    return g->winner;
+}
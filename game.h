@@ -0,0 +1,132 @@
+/**
+* @file game.h
+* @brief Rules and state for the two-player match-the-top-card game.
+*
+* A game is a shuffled hidden deck, a face-up played pile and two sorted
+* hands. On each turn the player plays the first card in their hand that
+* matches the top of the played pile, or draws when none does; the first to
+* empty their hand wins. Used by the interactive/batch front end in menu.c
+* and by the multi-threaded simulator.
+*
+* With use_shoe set the hidden deck is replaced by a Shoe of card counts
+* (shoe.h), so a game of any number of packs takes the same small amount
+* of memory; only cards that have left the hidden pile are real Cards.
+*/
+#ifndef GAME_H
+#define GAME_H
+
+#include "Card.h"
+#include "deck.h"
+#include "cardSet.h"
+#include "handIndex.h"
+#include "hand.h"
+#include "rng.h"
+#include "shoe.h"
+#include "zobrist.h"
+
+/* a player's hand plus mirrors that answer match queries without a scan */
+typedef struct {
+    Hand hand;         /* cards held, always in card_compare order */
+    CardSet set;       /* same cards as a bitset */
+    HandIndex index;   /* same cards as a count matrix */
+    int use_set;       /* 1 for single-pack games, where set is maintained */
+    int use_index;     /* 1 for multi-pack games, where index is maintained */
+} Player;
+
+/* how much a game prints */
+#define VERBOSITY_QUIET 0    /* nothing */
+#define VERBOSITY_SUMMARY 1  /* one line per game (batch mode) */
+#define VERBOSITY_TURNS 2    /* every deal, play and draw */
+
+/* moves other than "play the card at hand index i" (i >= 0) */
+#define MOVE_DRAW -1         /* nothing playable: take the top hidden card */
+#define MOVE_PASS -2         /* nothing playable and nothing to draw */
+
+/* everything one game needs: decks, players, generator and counters */
+typedef struct {
+    CardDeck hidden;       /* face-down draw pile; stays empty with use_shoe */
+    Shoe shoe;             /* face-down draw pile as counts, with use_shoe */
+    CardDeck played;       /* face-up pile */
+    Player players[2];
+    Rng rng;
+    int verbosity;         /* VERBOSITY_* level */
+    int interactive;       /* pause for ENTER between steps */
+    int use_shoe;          /* 1 to draw from shoe, not hidden; set before game_start */
+    int64_t packs;         /* packs the game was dealt from */
+    int turn;              /* player to move next, 1 or 2 */
+    int passes;            /* consecutive turns with no play and no draw */
+    int winner;            /* 1 or 2 once won; 0 while playing or if stalled */
+    int over;              /* 1 once the game has ended */
+    int last_move;         /* move made by the last turn (index or MOVE_*) */
+    int turns;             /* turns taken this game */
+    int refills;           /* times hidden was rebuilt from played */
+    Zobrist zobrist;       /* zone sums behind game_hash(), kept by every card move */
+} Game;
+
+void player_init(Player* p, int64_t packs);
+void player_take(Player* p, Card c);
+void player_take_all(Player* p, CardView cards);
+Card player_give(Player* p, int index);
+
+void wait_for_enter(void);
+void print_player_hand(int player_num, const Hand* player);
+
+int find_matching_card(Player* p, Card top);
+void play_card(Game* g, int player_num, int index);
+int draw_card(Game* g, int player_num);
+int refill_if_needed(Game* g);
+int hidden_is_empty(const Game* g);
+int64_t hidden_size(const Game* g);
+void deal_hands(Game* g, int per_player);
+
+/**
+* @brief Set up a new game: shuffle, deal, and turn the first card up.
+* @details If the deck runs out before a card can be turned up, the game
+*          is left over with no winner.
+*/
+void game_start(Game* g, int64_t packs);
+
+/**
+* @brief The move the built-in policy makes for g->turn: the first playable
+*        card, else MOVE_DRAW, else MOVE_PASS.
+*/
+int game_choose_move(Game* g);
+
+/**
+* @brief Play a given move for g->turn.
+* @return 1 if the game goes on, 0 once it is over, -1 if the move is not
+*         legal here (the game is left unchanged).
+*/
+int game_apply(Game* g, int move);
+
+/**
+* @brief Play one turn for g->turn with the built-in policy.
+* @return 1 if the game goes on, 0 once it is over (see g->winner).
+*/
+int game_step(Game* g);
+
+/**
+* @brief Position hash of a started game: hands, hidden pile, top card,
+*        seat to move and passes (zobrist.h). O(1); kept up to date by
+*        every move.
+*/
+uint64_t game_hash(const Game* g);
+
+/**
+* @brief Recompute the sums behind game_hash() from the piles, for a game
+*        whose piles were filled directly (a loaded snapshot).
+*/
+void game_rehash(Game* g);
+
+/**
+* @brief Free the decks and hands of a started (or loaded) game.
+*/
+void game_free(Game* g);
+
+/**
+* @brief Deal and play one full game with the Game's rng and verbosity.
+* @return The winning player (1 or 2), or 0 if the game stalled.
+*/
+int play_game(Game* g, int64_t packs);
+
+#endif
@@ -0,0 +1,266 @@
+#include <stdlib.h>
+#include <string.h>
+#include "gameBatch.h"
+#include "perf.h"
+
+/* Allocate every lane array */
+int batch_init(GameBatch* b, int lanes, int64_t packs)
+{
+    memset(b, 0, sizeof(*b));
+    if (lanes < 1 || packs < 1 || packs > BATCH_MAX_PACKS)
+        return -1;
+
+    size_t n = (size_t)lanes;
+    b->lanes = lanes;
+    b->packs = packs;
+    b->cap = packs * 52;
+
+    for (int s = 0; s < 2; s++) {
+        b->held[s] = calloc(n, sizeof(CardSet));
+        b->count[s] = calloc(n * 64, 1);
+        b->handSize[s] = calloc(n, sizeof(uint32_t));
+    }
+    b->top = calloc(n, sizeof(Card));
+    b->match = calloc(n, sizeof(CardSet));
+    b->turn = calloc(n, 1);
+    b->passes = calloc(n, 1);
+    b->active = calloc(n, 1);
+    b->turns = calloc(n, sizeof(uint32_t));
+    b->refills = calloc(n, sizeof(uint32_t));
+    b->hiddenSize = calloc(n, sizeof(uint32_t));
+    b->playedSize = calloc(n, sizeof(uint32_t));
+    b->hidden = malloc(n * (size_t)b->cap);
+    b->played = malloc(n * (size_t)b->cap);
+    b->playable = calloc(n, sizeof(CardSet));
+    b->lists = calloc(2 * n, sizeof(int));
+    b->pack = malloc((size_t)b->cap);
+
+    if (!b->held[0] || !b->held[1] || !b->count[0] || !b->count[1]
+        || !b->handSize[0] || !b->handSize[1] || !b->top || !b->match || !b->turn
+        || !b->passes || !b->active || !b->turns || !b->refills
+        || !b->hiddenSize || !b->playedSize || !b->hidden || !b->played
+        || !b->playable || !b->lists || !b->pack) {
+        batch_free(b);
+        return -1;
+    }
+
+    for (int64_t i = 0; i < b->cap; i++)
+        b->pack[i] = card_create((Suit)(i / 13 % 4), (Rank)(TWO + i % 13));
+    return 0;
+}
+
+/* a uniformly random hidden card; the last one fills its slot */
+static inline Card lane_draw(GameBatch* b, int lane, Rng* rng)
+{
+    Card* hidden = b->hidden + (int64_t)lane * b->cap;
+    uint32_t r = rng_bounded(rng, b->hiddenSize[lane]);
+    Card c = hidden[r];
+    hidden[r] = hidden[--b->hiddenSize[lane]];
+    return c;
+}
+
+static inline void lane_take(GameBatch* b, int lane, int seat, Card c)
+{
+    b->count[seat][(size_t)lane * 64 + c.bits]++;
+    b->held[seat][lane] |= cardset_bit(c);
+    b->handSize[seat][lane]++;
+}
+
+/* the held bit goes with the last copy; masked, since with several packs
+ * that is unpredictable */
+static inline void lane_give(GameBatch* b, int lane, int seat, Card c)
+{
+    uint8_t left = --b->count[seat][(size_t)lane * 64 + c.bits];
+    b->held[seat][lane] &= ~(cardset_bit(c) & -(CardSet)(left == 0));
+    b->handSize[seat][lane]--;
+}
+
+/* deal a fresh game into a lane, as game_start() does: 8 cards each, then
+ * the top card. Built in locals and stored once: the lane arrays would
+ * chain every card through a store and a reload. */
+static void lane_deal(GameBatch* b, int lane, Rng* rng)
+{
+    Card* hidden = b->hidden + (int64_t)lane * b->cap;
+    uint32_t left = (uint32_t)b->cap;
+
+    memcpy(hidden, b->pack, (size_t)b->cap);
+    for (int s = 0; s < 2; s++) {
+        uint8_t* count = b->count[s] + (size_t)lane * 64;
+        CardSet held = CARDSET_EMPTY;
+
+        memset(count, 0, 64);
+        for (int k = 0; k < 8; k++) {
+            uint32_t r = rng_bounded(rng, left);
+            Card c = hidden[r];
+            hidden[r] = hidden[--left];
+            count[c.bits]++;
+            held |= cardset_bit(c);
+        }
+        b->held[s][lane] = held;
+        b->handSize[s][lane] = 8;
+    }
+
+    uint32_t r = rng_bounded(rng, left);
+    b->top[lane] = hidden[r];
+    b->match[lane] = cardset_match_mask(hidden[r]);
+    hidden[r] = hidden[--left];
+
+    b->hiddenSize[lane] = left;
+    b->playedSize[lane] = 0;
+    b->turn[lane] = 1;
+    b->passes[lane] = 0;
+    b->turns[lane] = 0;
+    b->refills[lane] = 0;
+    b->active[lane] = 1;
+    b->started++;
+}
+
+/* record a lane's result, then deal it another game or mask it out */
+static void lane_finish(GameBatch* b, int lane, int winner, BatchResult* out, Rng* rng)
+{
+    out->winner = winner;
+    out->turns = (int)b->turns[lane];
+    out->refills = (int)b->refills[lane];
+
+    if (b->started < b->games)
+        lane_deal(b, lane, rng);
+    else {
+        b->active[lane] = 0;
+        b->running--;
+    }
+}
+
+/* Deal a game into every lane there is a game for */
+void batch_start(GameBatch* b, uint64_t games)
+{
+    Rng rng = b->rng;
+
+    b->games = games;
+    b->started = 0;
+    b->running = 0;
+    for (int i = 0; i < b->lanes; i++) {
+        if (b->started < games) {
+            lane_deal(b, i, &rng);
+            b->running++;
+        }
+        else
+            b->active[i] = 0;
+    }
+    b->rng = rng;
+}
+
+/* One turn in every running lane, with the rules of do_turn() in game.c.
+ * Whether a lane plays or draws is a coin flip to the branch predictor, so
+ * lanes are first sorted into a list that plays and a list that draws and
+ * each list is then worked through without a data-dependent branch. */
+int batch_step(GameBatch* b, BatchResult* done)
+{
+    int lanes = b->lanes;
+    int finished = 0;
+    int plays = 0, draws = 0;
+    int* playList = b->lists;
+    int* drawList = b->lists + lanes;
+    CardSet* playable = b->playable;
+    const CardSet* held0 = b->held[0];
+    const CardSet* held1 = b->held[1];
+    const uint8_t* turn = b->turn;
+    const CardSet* match = b->match;
+    /* a local copy: stores to the byte arrays could alias b->rng, which
+     * would send every draw's state through memory */
+    Rng rng = b->rng;
+
+    PERF_COUNT(PERF_TURNS, b->running);
+
+    /* pass 1: every lane's playable cards, branch-free */
+    for (int i = 0; i < lanes; i++) {
+        /* masked, not selected: seats alternate at random across lanes */
+        CardSet seat1 = -(CardSet)(turn[i] == 1);
+        CardSet held = (held0[i] & seat1) | (held1[i] & ~seat1);
+        playable[i] = held & match[i];
+    }
+
+    /* pass 2: split the running lanes into players and drawers; a lane
+     * that can do neither passes */
+    for (int i = 0; i < lanes; i++) {
+        int live = b->active[i];
+        int play = live & (playable[i] != 0);
+        int draw = live & !play & (b->hiddenSize[i] != 0);
+        playList[plays] = i;
+        plays += play;
+        drawList[draws] = i;
+        draws += draw;
+        b->turns[i] += (uint32_t)live;
+        b->passes[i] = (uint8_t)(play | draw ? 0 : b->passes[i] + live);
+    }
+
+    /* pass 3: lowest playable card onto the played pile, as find_matching_card() picks */
+    for (int k = 0; k < plays; k++) {
+        int i = playList[k];
+        Card c = { (uint8_t)cardset_lowest_bit(playable[i]) };
+        lane_give(b, i, b->turn[i] - 1, c);
+        b->played[(int64_t)i * b->cap + b->playedSize[i]++] = b->top[i];
+        b->top[i] = c;
+        b->match[i] = cardset_match_mask(c);
+    }
+
+    /* pass 4: draws */
+    for (int k = 0; k < draws; k++) {
+        int i = drawList[k];
+        lane_take(b, i, b->turn[i] - 1, lane_draw(b, i, &rng));
+    }
+
+    /* pass 5: ends of game, refills and the next seat; all rare but the last */
+    for (int i = 0; i < lanes; i++) {
+        if (!b->active[i])
+            continue;
+
+        int seat = b->turn[i] - 1;
+        if (b->passes[i] == 2) {
+            lane_finish(b, i, 0, &done[finished++], &rng);     /* stalemate */
+            continue;
+        }
+        if (b->handSize[seat][i] == 0) {
+            lane_finish(b, i, seat + 1, &done[finished++], &rng);
+            continue;
+        }
+
+        if (b->hiddenSize[i] == 0 && b->playedSize[i] > 0) {
+            /* order does not matter, so refilling is one copy */
+            PERF_COUNT(PERF_REFILL_CARDS, b->playedSize[i]);
+            memcpy(b->hidden + (int64_t)i * b->cap, b->played + (int64_t)i * b->cap, b->playedSize[i]);
+            b->hiddenSize[i] = b->playedSize[i];
+            b->playedSize[i] = 0;
+            b->refills[i]++;
+        }
+
+        b->turn[i] = (uint8_t)(3 - b->turn[i]);
+    }
+
+    b->rng = rng;
+    return finished;
+}
+
+/* Free every lane array */
+void batch_free(GameBatch* b)
+{
+    for (int s = 0; s < 2; s++) {
+        free(b->held[s]);
+        free(b->count[s]);
+        free(b->handSize[s]);
+    }
+    free(b->top);
+    free(b->match);
+    free(b->turn);
+    free(b->passes);
+    free(b->active);
+    free(b->turns);
+    free(b->refills);
+    free(b->hiddenSize);
+    free(b->playedSize);
+    free(b->hidden);
+    free(b->played);
+    free(b->playable);
+    free(b->lists);
+    free(b->pack);
+    memset(b, 0, sizeof(*b));
+}
@@ -0,0 +1,129 @@
+/**
+* @file gameBatch.h
+* @brief Many independent games stepped together, one turn per lane per call.
+*
+* Playing games one at a time spends most of each turn on branches and
+* pointer chasing through decks and hands. A GameBatch keeps N games
+* ("lanes") in structure-of-arrays form instead: one array per field, one
+* element per lane. A hand is a CardSet of the cards held plus a count
+* per card; a lane's 64 counts share one cache line, since every move
+* touches a different card in each lane. The top card, its match mask,
+* turn, sizes and counters are plain per-lane arrays. Each step first
+* computes every lane's playable set (held & match mask) in one
+* branch-free loop of ANDs that compilers vectorize (at -O3 with gcc),
+* then moves one card per lane.
+*
+* At one pack, bench puts a batch at about 3.5x the game row per game
+* (roughly 1.2 us against 4.3 us). What is left is mostly the random
+* draws and the scattered hand-count updates, which no lane layout makes
+* contiguous. The end-of-turn checks for a finished game or an empty
+* hidden pile are almost never taken and predict well, so moving them
+* out of the step loop measured no faster.
+*
+* The hidden and played piles are per-lane slabs of cards in no order.
+* Drawing picks a uniformly random hidden card and fills its slot with the
+* last one, so every draw costs O(1) and no shuffle is ever needed; like a
+* Shoe (shoe.h), this hands out cards exactly as a shuffled deck would. A
+* refill copies the played slab into the hidden one. The move policy is
+* game_choose_move()'s, so a batch plays the same game as game_step() with
+* use_shoe set, though not the same deals for a given seed.
+*
+* A finished lane reports its result and is dealt a new game until the
+* batch has started the number of games it was asked for; after that it is
+* masked out of later steps.
+*/
+#ifndef GAMEBATCH_H
+#define GAMEBATCH_H
+
+#include <stdint.h>
+#include "Card.h"
+#include "cardSet.h"
+#include "rng.h"
+
+#define BATCH_MAX_PACKS 255 // Hand counts are one byte
+#define BATCH_DEFAULT_LANES 256 // Enough lanes to hide memory latency, few enough to stay in L2
+
+
+/**
+* @struct BatchResult
+* @brief How one game of a batch ended.
+*/
+typedef struct {
+	int winner; // 1 or 2, or 0 if the game stalled
+	int turns; // Turns taken
+	int refills; // Times hidden was rebuilt from played
+} BatchResult;
+
+
+/**
+* @struct GameBatch
+* @brief Lane state, one array element per lane. Seat arrays are [0] for
+*        player 1 and [1] for player 2.
+*/
+typedef struct {
+	int lanes; // Number of lanes
+	int64_t packs; // Packs per game
+	int64_t cap; // Cards in a full deck: each pile slab's size
+	CardSet* held[2]; // Cards each seat holds at least one of
+	uint8_t* count[2]; // Copies of each card held, [lane * 64 + card]
+	uint32_t* handSize[2];
+	Card* top; // Face-up card
+	CardSet* match; // cardset_match_mask() of top, kept so the playable pass is plain ANDs
+	uint8_t* turn; // Seat to move, 1 or 2
+	uint8_t* passes; // Consecutive turns with no play and no draw
+	uint8_t* active; // 1 while the lane has a game in progress
+	uint32_t* turns;
+	uint32_t* refills;
+	uint32_t* hiddenSize;
+	uint32_t* playedSize; // Cards under the top card
+	Card* hidden; // Lane i's hidden cards are hidden[i * cap ...], unordered
+	Card* played; // Lane i's cards under the top, played[i * cap ...], unordered
+	CardSet* playable; // Scratch for batch_step()
+	int* lists; // Scratch for batch_step(): lanes that play, then lanes that draw
+	Card* pack; // cap cards in pack order, copied into each new deal
+	Rng rng; // Shared by every lane; seed before batch_start()
+	uint64_t games; // Games to play in all
+	uint64_t started; // Games dealt so far
+	int running; // Lanes with a game in progress
+} GameBatch;
+
+
+/**
+* @brief Allocate a batch of lanes games of packs packs each.
+* @return 0 on success, -1 if out of memory or packs is not in
+*         1..BATCH_MAX_PACKS.
+*/
+int batch_init(GameBatch* b, int lanes, int64_t packs);
+
+
+/**
+* @brief Start playing games games, dealing one into every lane that
+*        gets one. Seed b->rng first.
+*/
+void batch_start(GameBatch* b, uint64_t games);
+
+
+/**
+* @brief Play one turn in every running lane.
+* @param done Room for b->lanes results; one is written per game that ended.
+* @return Number of games that ended this step.
+*/
+int batch_step(GameBatch* b, BatchResult* done);
+
+
+/**
+* @brief Returns the number of lanes with a game in progress; 0 once every
+*        game has been played.
+*/
+static inline int batch_running(const GameBatch* b)
+{
+	return b->running;
+}
+
+
+/**
+* @brief Free a batch's arrays.
+*/
+void batch_free(GameBatch* b);
+
+#endif
@@ -0,0 +1,260 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gameState.h"
+
+/* add a pile's cards to a count array; no count passes the pack count */
+static void count_cards(uint8_t* counts, uint32_t* size, const Card* cards, int64_t n)
+{
+    for (int64_t i = 0; i < n; i++)
+        counts[cards[i].bits]++;
+    *size += (uint32_t)n;
+}
+
+/* a zone's sum straight from its counts */
+static uint64_t zone_sum(const uint8_t* counts)
+{
+    uint64_t sum = 0;
+    for (int k = 0; k < GAMESTATE_SLOTS; k++)
+        sum += zobrist_keys[k] * counts[k];
+    return sum;
+}
+
+/* count a deck, top card first; *top gets the top card if asked for */
+static void count_deck(uint8_t* counts, uint32_t* size, const CardDeck* deck, Card* top)
+{
+    int64_t n = carddeck_size(deck);
+    Card* cards = carddeck_to_array(deck);
+
+    if (!cards && n > 0) {
+        fprintf(stderr, "Memory allocation failed in gamestate_from_game()\n");
+        exit(EXIT_FAILURE);
+    }
+    if (top && n > 0) {
+        *top = cards[0];
+        count_cards(counts, size, cards + 1, n - 1);
+    }
+    else
+        count_cards(counts, size, cards, n);
+    free(cards);
+}
+
+/* Snapshot a Game's piles as counts */
+int gamestate_from_game(GameState* s, const Game* g)
+{
+    memset(s, 0, sizeof(*s));
+    if (g->packs > GAMESTATE_MAX_PACKS)
+        return 0;
+
+    for (int p = 0; p < 2; p++) {
+        const Hand* h = &g->players[p].hand;
+        count_cards(s->hand[p], &s->handSize[p], h->cards, h->size);
+        for (int64_t i = 0; i < h->size; i++)
+            cardset_insert(&s->held[p], h->cards[i]);
+    }
+
+    if (g->use_shoe) {
+        for (int k = 0; k < SHOE_KINDS; k++) {
+            Card c = card_create((Suit)(k / 13), (Rank)(TWO + k % 13));
+            s->hidden[c.bits] = (uint8_t)g->shoe.count[k];
+        }
+        s->hiddenSize = (uint32_t)shoe_size(&g->shoe);
+    }
+    else
+        count_deck(s->hidden, &s->hiddenSize, &g->hidden, NULL);
+    count_deck(s->played, &s->playedSize, &g->played, &s->top);
+
+    /* from the counts, not g->zobrist, so the state stands on its own */
+    s->zobrist.sum[ZOBRIST_HAND1] = zone_sum(s->hand[0]);
+    s->zobrist.sum[ZOBRIST_HAND2] = zone_sum(s->hand[1]);
+    s->zobrist.sum[ZOBRIST_HIDDEN] = zone_sum(s->hidden);
+    s->zobrist.sum[ZOBRIST_PLAYED] = zone_sum(s->played);
+
+    s->turns = (uint32_t)g->turns;
+    s->refills = (uint32_t)g->refills;
+    s->turn = (uint8_t)g->turn;
+    s->passes = (uint8_t)g->passes;
+    s->winner = (uint8_t)g->winner;
+    s->over = (uint8_t)g->over;
+    return 1;
+}
+
+/* Every legal move, plays in card order */
+int gamestate_legal_moves(const GameState* s, int* moves)
+{
+    if (s->over)
+        return 0;
+
+    CardSet it = gamestate_playable(s);
+    Card c;
+    int n = 0;
+    while (cardset_next(&it, &c))
+        moves[n++] = c.bits;
+    if (n == 0)
+        moves[n++] = s->hiddenSize ? MOVE_DRAW : MOVE_PASS;
+    return n;
+}
+
+/* Same rules as move_is_legal() in game.c */
+int gamestate_is_legal(const GameState* s, int move)
+{
+    if (s->over)
+        return 0;
+
+    CardSet playable = gamestate_playable(s);
+    if (move >= 0)
+        return move < GAMESTATE_SLOTS && ((playable >> move) & 1);
+    if (playable)
+        return 0;
+    if (move == MOVE_DRAW)
+        return s->hiddenSize != 0;
+    return move == MOVE_PASS && s->hiddenSize == 0;
+}
+
+static void take_card(GameState* s, int seat, Card c)
+{
+    s->hand[seat][c.bits]++;
+    s->handSize[seat]++;
+    cardset_insert(&s->held[seat], c);
+    zobrist_add(&s->zobrist, ZOBRIST_HAND1 + seat, c);
+}
+
+static void give_card(GameState* s, int seat, Card c)
+{
+    if (--s->hand[seat][c.bits] == 0)
+        cardset_remove(&s->held[seat], c);
+    s->handSize[seat]--;
+    zobrist_remove(&s->zobrist, ZOBRIST_HAND1 + seat, c);
+}
+
+/* the end of every turn that did not stall: win check, refill, next seat */
+static int end_turn(GameState* s, GameUndo* undo)
+{
+    if (s->handSize[s->turn - 1] == 0) {
+        s->winner = s->turn;
+        s->over = 1;
+        return 0;
+    }
+
+    /* hidden is empty, so the played cards simply become its counts */
+    if (s->hiddenSize == 0 && s->playedSize > 0) {
+        memcpy(s->hidden, s->played, sizeof(s->hidden));
+        memset(s->played, 0, sizeof(s->played));
+        s->hiddenSize = s->playedSize;
+        s->playedSize = 0;
+        s->refills++;
+        zobrist_refill(&s->zobrist);
+        undo->refilled = 1;
+    }
+
+    s->turn = (uint8_t)(3 - s->turn);
+    return 1;
+}
+
+/* fields every undo needs */
+static void begin_move(GameState* s, int move, GameUndo* undo)
+{
+    undo->move = move;
+    undo->top = s->top;
+    undo->passes = s->passes;
+    undo->refilled = 0;
+    s->turns++;
+}
+
+/* Play, pass, or draw a random hidden card */
+int gamestate_apply(GameState* s, int move, Rng* rng, GameUndo* undo)
+{
+    GameUndo scratch;
+    if (!undo)
+        undo = &scratch;
+
+    if (move == MOVE_DRAW) {
+        /* the r-th hidden card in card order */
+        uint32_t r = rng_bounded(rng, s->hiddenSize);
+        int k = 0;
+        while (r >= s->hidden[k])
+            r -= s->hidden[k++];
+        return gamestate_apply_draw(s, (Card){ (uint8_t)k }, undo);
+    }
+
+    begin_move(s, move, undo);
+    if (move >= 0) {
+        Card c = { (uint8_t)move };
+        give_card(s, s->turn - 1, c);
+        s->played[s->top.bits]++;
+        s->playedSize++;
+        zobrist_add(&s->zobrist, ZOBRIST_PLAYED, s->top);
+        s->top = c;
+        s->passes = 0;
+        undo->card = c;
+    }
+    else if (++s->passes == 2) {
+        s->over = 1;    /* nobody can play or draw: stalemate */
+        return 0;
+    }
+    return end_turn(s, undo);
+}
+
+/* Draw a given card */
+int gamestate_apply_draw(GameState* s, Card drawn, GameUndo* undo)
+{
+    GameUndo scratch;
+    if (!undo)
+        undo = &scratch;
+
+    begin_move(s, MOVE_DRAW, undo);
+    s->hidden[drawn.bits]--;
+    s->hiddenSize--;
+    zobrist_remove(&s->zobrist, ZOBRIST_HIDDEN, drawn);
+    take_card(s, s->turn - 1, drawn);
+    s->passes = 0;
+    undo->card = drawn;
+    return end_turn(s, undo);
+}
+
+/* Reverse one move, last step first */
+void gamestate_undo(GameState* s, const GameUndo* undo)
+{
+    if (s->over) {
+        s->over = 0;    /* ended on this move, so the turn never passed */
+        s->winner = 0;
+    }
+    else
+        s->turn = (uint8_t)(3 - s->turn);
+
+    if (undo->refilled) {
+        memcpy(s->played, s->hidden, sizeof(s->played));
+        memset(s->hidden, 0, sizeof(s->hidden));
+        s->playedSize = s->hiddenSize;
+        s->hiddenSize = 0;
+        s->refills--;
+        s->zobrist.sum[ZOBRIST_PLAYED] = s->zobrist.sum[ZOBRIST_HIDDEN];
+        s->zobrist.sum[ZOBRIST_HIDDEN] = 0;
+    }
+
+    int seat = s->turn - 1;
+    if (undo->move >= 0) {
+        s->top = undo->top;
+        s->played[undo->top.bits]--;
+        s->playedSize--;
+        zobrist_remove(&s->zobrist, ZOBRIST_PLAYED, undo->top);
+        take_card(s, seat, undo->card);
+    }
+    else if (undo->move == MOVE_DRAW) {
+        give_card(s, seat, undo->card);
+        s->hidden[undo->card.bits]++;
+        s->hiddenSize++;
+        zobrist_add(&s->zobrist, ZOBRIST_HIDDEN, undo->card);
+    }
+
+    s->passes = undo->passes;
+    s->turns--;
+}
+
+/* hands are sorted, so a card's index is where it would be inserted */
+int gamestate_game_move(const Game* g, int move)
+{
+    if (move < 0)
+        return move;
+    return (int)hand_lower_bound(&g->players[g->turn - 1].hand, (Card){ (uint8_t)move });
+}
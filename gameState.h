@@ -0,0 +1,152 @@
+/**
+* @file gameState.h
+* @brief A whole game position in one flat, fixed-size value for search.
+*
+* A Game owns heap-allocated decks and hands, so copying one means copying
+* every pile. Nothing in the rules depends on the order of a hand (hands
+* are kept sorted) or of the played pile below its top card, and the
+* hidden pile's order is unknown to both players, so a GameState keeps
+* only how many of each card sit in each place. Counts are indexed by the
+* packed card byte (64 slots, 13 used per suit) and are one byte each,
+* which limits a state to GAMESTATE_MAX_PACKS packs. The whole value is
+* about 340 bytes with no pointers: cloning is plain assignment. It also
+* carries the zone sums of zobrist.h, so gamestate_hash() is O(1) and
+* equals game_hash() of the game it was captured from.
+*
+* A draw is a chance event: gamestate_apply() picks the drawn card at
+* random from the hidden counts, which is exactly what a player who cannot
+* see the hidden pile should expect. gamestate_apply_draw() takes the card
+* instead, so a search can weigh every outcome by count / hiddenSize.
+*
+* Moves are the card byte to play (0..63) or MOVE_DRAW / MOVE_PASS, and
+* follow the same rules as game_apply(). Every apply fills a GameUndo that
+* gamestate_undo() reverses exactly, for search that walks one state down
+* and back up instead of cloning.
+*/
+#ifndef GAMESTATE_H
+#define GAMESTATE_H
+
+#include <stdint.h>
+#include "Card.h"
+#include "cardSet.h"
+#include "game.h"
+#include "rng.h"
+#include "zobrist.h"
+
+#define GAMESTATE_SLOTS 64 // One count per packed card byte
+#define GAMESTATE_MAX_PACKS 255 // Counts are one byte
+#define GAMESTATE_MAX_MOVES 52 // Distinct cards that can be played, at most
+
+
+/**
+* @struct GameState
+* @brief Card counts per place plus the turn counters of a Game.
+*/
+typedef struct {
+	uint8_t hand[2][GAMESTATE_SLOTS]; // Copies of each card in each seat's hand
+	uint8_t hidden[GAMESTATE_SLOTS]; // Copies of each card in the hidden pile
+	uint8_t played[GAMESTATE_SLOTS]; // Copies of each card under the top card
+	CardSet held[2]; // Cards each seat holds at least one of
+	Zobrist zobrist; // Zone sums behind gamestate_hash()
+	uint32_t handSize[2];
+	uint32_t hiddenSize;
+	uint32_t playedSize; // Cards under the top card
+	uint32_t turns; // Turns taken
+	uint32_t refills; // Times hidden was rebuilt from played
+	Card top; // Face-up card
+	uint8_t turn; // Seat to move, 1 or 2
+	uint8_t passes; // Consecutive turns with no play and no draw
+	uint8_t winner; // 1 or 2 once won; 0 while playing or if stalled
+	uint8_t over; // 1 once the game has ended
+} GameState;
+
+
+/**
+* @struct GameUndo
+* @brief What gamestate_undo() needs to reverse one move.
+*/
+typedef struct {
+	int move; // Move that was applied
+	Card card; // Card played or drawn
+	Card top; // Top card before the move
+	uint8_t passes; // passes before the move
+	uint8_t refilled; // 1 if the move ended with a refill
+} GameUndo;
+
+
+/**
+* @brief Capture a started (or loaded) game.
+* @return 1 on success, 0 if the game has more than GAMESTATE_MAX_PACKS packs.
+*/
+int gamestate_from_game(GameState* s, const Game* g);
+
+
+/**
+* @brief Copy a state. A plain assignment; here to say so.
+*/
+static inline void gamestate_clone(GameState* dst, const GameState* src)
+{
+	*dst = *src;
+}
+
+
+/**
+* @brief Position hash; the same as game_hash() for the same position.
+*/
+static inline uint64_t gamestate_hash(const GameState* s)
+{
+	return zobrist_hash(&s->zobrist, s->top, s->turn, s->passes);
+}
+
+
+/**
+* @brief Cards the seat to move may play: those matching the top card.
+*/
+static inline CardSet gamestate_playable(const GameState* s)
+{
+	return s->held[s->turn - 1] & cardset_match_mask(s->top);
+}
+
+
+/**
+* @brief Write every legal move to moves.
+* @param moves Room for GAMESTATE_MAX_MOVES moves.
+* @return Number of moves; 0 once the game is over.
+*/
+int gamestate_legal_moves(const GameState* s, int* moves);
+
+
+/**
+* @brief Returns 1 if move is legal for the seat to move.
+*/
+int gamestate_is_legal(const GameState* s, int move);
+
+
+/**
+* @brief Apply a legal move, drawing at random from hidden for MOVE_DRAW.
+* @param undo Filled so gamestate_undo() can reverse the move; may be NULL.
+* @return 1 if the game goes on, 0 once it is over.
+*/
+int gamestate_apply(GameState* s, int move, Rng* rng, GameUndo* undo);
+
+
+/**
+* @brief Apply MOVE_DRAW with a given card, which hidden must hold.
+* @return 1 if the game goes on, 0 once it is over.
+*/
+int gamestate_apply_draw(GameState* s, Card drawn, GameUndo* undo);
+
+
+/**
+* @brief Reverse the move undo was filled for. Moves must be undone in the
+*        opposite order to the one they were applied in.
+*/
+void gamestate_undo(GameState* s, const GameUndo* undo);
+
+
+/**
+* @brief The game_apply() move (hand index or MOVE_*) for a GameState move.
+*/
+int gamestate_game_move(const Game* g, int move);
+
+#endif
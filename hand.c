@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hand.h"
+
+/* grow storage geometrically so inserts are amortized O(1) in allocation */
+static void hand_reserve(Hand* hand, int64_t needed)
+{
+    if (needed <= hand->capacity)
+        return;
+
+    int64_t cap = hand->capacity ? hand->capacity * 2 : 16;
+    while (cap < needed)
+        cap *= 2;
+
+    Card* cards = (uint64_t)cap <= SIZE_MAX / sizeof(Card) ? realloc(hand->cards, sizeof(Card) * (size_t)cap) : NULL;
+    if (!cards) {
+        fprintf(stderr, "Memory allocation failed in hand_reserve()\n");
+        exit(EXIT_FAILURE);
+    }
+    hand->cards = cards;
+    hand->capacity = cap;
+}
+
+/* Initialize an empty hand */
+void hand_init(Hand* hand)
+{
+    hand->cards = NULL;
+    hand->size = 0;
+    hand->capacity = 0;
+}
+
+/* Free storage and reset */
+void hand_free(Hand* hand)
+{
+    free(hand->cards);
+    hand_init(hand);
+}
+
+/* Binary search on the packed byte */
+int64_t hand_lower_bound(const Hand* hand, Card c)
+{
+    int64_t lo = 0;
+    int64_t hi = hand->size;
+
+    while (lo < hi) {
+        int64_t mid = lo + (hi - lo) / 2;
+        if (hand->cards[mid].bits < c.bits)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* Insert in sorted slot: search, then shift the higher cards up one */
+int64_t hand_insert(Hand* hand, Card c)
+{
+    hand_reserve(hand, hand->size + 1);
+
+    int64_t pos = hand_lower_bound(hand, c);
+    memmove(hand->cards + pos + 1, hand->cards + pos, sizeof(Card) * (size_t)(hand->size - pos));
+    hand->cards[pos] = c;
+    hand->size++;
+    return pos;
+}
+
+/* Append the batch, then re-sort the whole hand in O(n + 64) */
+void hand_insert_all(Hand* hand, const Card* cards, int64_t count)
+{
+    if (count <= 0)
+        return;
+
+    hand_reserve(hand, hand->size + count);
+    memcpy(hand->cards + hand->size, cards, sizeof(Card) * (size_t)count);
+    hand->size += count;
+    card_sort(hand->cards, hand->size);
+}
+
+/* Remove by index, shifting the higher cards down one */
+int hand_remove_at(Hand* hand, int64_t index, Card* out)
+{
+    if (index < 0 || index >= hand->size)
+        return 0;
+
+    if (out)
+        *out = hand->cards[index];
+
+    memmove(hand->cards + index, hand->cards + index + 1, sizeof(Card) * (size_t)(hand->size - index - 1));
+    hand->size--;
+    return 1;
+}
+
+/* Remove one copy of a card */
+int hand_remove(Hand* hand, Card c)
+{
+    int64_t pos = hand_lower_bound(hand, c);
+    if (pos == hand->size || hand->cards[pos].bits != c.bits)
+        return 0;
+    return hand_remove_at(hand, pos, NULL);
+}
@@ -0,0 +1,73 @@
+/**
+* @file hand.h
+* @brief A player's hand: a card array that is always in card_compare order.
+*
+* Cards are inserted straight into their slot (binary search plus a short
+* shift of one-byte cards) and removed without disturbing the order, so a
+* hand never needs a full sort.
+*/
+#ifndef HAND_H
+#define HAND_H
+
+#include "Card.h"
+
+
+/**
+* @struct Hand
+* @brief Sorted, growable array of cards.
+*/
+typedef struct {
+	Card* cards; // Cards held, lowest first
+	int64_t size; // Number of cards held
+	int64_t capacity; // Slots allocated in cards
+} Hand;
+
+
+/**
+* @brief Initialize an empty hand.
+*/
+void hand_init(Hand* hand);
+
+
+/**
+* @brief Free the hand's storage and leave it empty.
+*/
+void hand_free(Hand* hand);
+
+
+/**
+* @brief Add many cards at once: one copy onto the end, then one counting sort.
+* @details Cheaper than count hand_insert() calls once count is more than a
+*          few cards, e.g. when a whole hand is dealt.
+*/
+void hand_insert_all(Hand* hand, const Card* cards, int64_t count);
+
+
+/**
+* @brief Index of the first card not lower than c (where c would be inserted).
+*/
+int64_t hand_lower_bound(const Hand* hand, Card c);
+
+
+/**
+* @brief Insert a card in its sorted slot.
+* @return Index the card was placed at.
+*/
+int64_t hand_insert(Hand* hand, Card c);
+
+
+/**
+* @brief Remove the card at an index; the rest stay sorted.
+* @param out Pointer where the removed card will be stored (may be NULL).
+* @return 1 if removed, 0 if index out of range.
+*/
+int hand_remove_at(Hand* hand, int64_t index, Card* out);
+
+
+/**
+* @brief Remove one copy of a card.
+* @return 1 if removed, 0 if the hand does not hold it.
+*/
+int hand_remove(Hand* hand, Card c);
+
+#endif
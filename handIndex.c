@@ -0,0 +1,55 @@
+#include <string.h>
+#include "handIndex.h"
+
+/* lowest rank whose bit is set in a present[] mask (mask must be nonzero) */
+static Rank lowest_rank(uint16_t mask)
+{
+    int r = TWO;
+    while (!(mask & (1u << r)))
+        r++;
+    return (Rank)r;
+}
+
+/* Initialize an empty index */
+void handindex_init(HandIndex* idx)
+{
+    memset(idx, 0, sizeof(*idx));
+}
+
+/* First match in sorted order: lower suits can only match on rank,
+ * the top card's suit matches on its lowest card, higher suits on rank.
+ * At most four suit checks whatever the hand size. */
+int handindex_first_playable(const HandIndex* idx, Card top, Card* out)
+{
+    Suit top_suit = card_suit(top);
+    Rank top_rank = card_rank(top);
+    uint16_t rank_bit = (uint16_t)(1u << top_rank);
+
+    for (int s = CLUB; s <= DIAMOND; s++) {
+        if (s == (int)top_suit) {
+            if (idx->present[s]) {
+                *out = card_create((Suit)s, lowest_rank(idx->present[s]));
+                return 1;
+            }
+        }
+        else if (idx->present[s] & rank_bit) {
+            *out = card_create((Suit)s, top_rank);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Cards sorting before c: whole lower suits plus lower ranks of its suit */
+uint32_t handindex_position(const HandIndex* idx, Card c)
+{
+    Suit suit = card_suit(c);
+    int rank = (int)card_rank(c) - TWO;
+    uint32_t pos = 0;
+
+    for (int s = CLUB; s < (int)suit; s++)
+        pos += idx->suit_total[s];
+    for (int r = 0; r < rank; r++)
+        pos += idx->count[suit][r];
+    return pos;
+}
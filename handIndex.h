@@ -0,0 +1,103 @@
+/**
+* @file handIndex.h
+* @brief Per-(suit, rank) card counts for hands that may hold duplicates.
+*
+* A HandIndex mirrors a hand from a multi-pack game as a 4x13 count matrix
+* plus per-suit and per-rank totals. Adding or removing a card is O(1), and
+* so are the questions the game loop asks every turn: how many cards match
+* the top card, which is the first one in card_compare order, and where a
+* card sits in the sorted hand.
+*/
+#ifndef HANDINDEX_H
+#define HANDINDEX_H
+
+#include <stdint.h>
+#include "Card.h"
+
+#define HANDINDEX_SUITS 4 // Rows of the count matrix
+#define HANDINDEX_RANKS 13 // Columns of the count matrix (TWO..ACE)
+
+
+/**
+* @struct HandIndex
+* @brief Count matrix view of a multiset of cards.
+*/
+typedef struct {
+	uint32_t count[HANDINDEX_SUITS][HANDINDEX_RANKS]; // Copies held of each card, indexed [suit][rank - TWO]
+	uint32_t suit_total[HANDINDEX_SUITS]; // Cards held of each suit
+	uint32_t rank_total[HANDINDEX_RANKS]; // Cards held of each rank, indexed [rank - TWO]
+	uint16_t present[HANDINDEX_SUITS]; // Bit r set when count[suit][r - TWO] > 0, for each suit
+	uint32_t size; // Total cards held
+} HandIndex;
+
+
+/**
+* @brief Initialize an empty index.
+*/
+void handindex_init(HandIndex* idx);
+
+
+/**
+* @brief Record one more copy of a card.
+*/
+static inline void handindex_add(HandIndex* idx, Card c)
+{
+	Suit s = card_suit(c);
+	int r = (int)card_rank(c) - TWO;
+
+	if (idx->count[s][r]++ == 0)
+		idx->present[s] |= (uint16_t)(1u << card_rank(c));
+	idx->suit_total[s]++;
+	idx->rank_total[r]++;
+	idx->size++;
+}
+
+
+/**
+* @brief Forget one copy of a card.
+* @return 1 if removed, 0 if the card was not held.
+*/
+static inline int handindex_remove(HandIndex* idx, Card c)
+{
+	Suit s = card_suit(c);
+	int r = (int)card_rank(c) - TWO;
+
+	if (idx->count[s][r] == 0)
+		return 0;
+	if (--idx->count[s][r] == 0)
+		idx->present[s] &= (uint16_t)~(1u << card_rank(c));
+	idx->suit_total[s]--;
+	idx->rank_total[r]--;
+	idx->size--;
+	return 1;
+}
+
+
+/**
+* @brief Number of held cards that card_matches() the top card.
+*/
+static inline uint32_t handindex_count_playable(const HandIndex* idx, Card top)
+{
+	Suit s = card_suit(top);
+	int r = (int)card_rank(top) - TWO;
+
+	/* same suit plus same rank, minus the exact card counted twice */
+	return idx->suit_total[s] + idx->rank_total[r] - idx->count[s][r];
+}
+
+
+/**
+* @brief Find the first held card (card_compare order) matching the top card.
+* @param out Pointer where the matching card will be stored.
+* @return 1 if the hand holds a match, 0 otherwise.
+*/
+int handindex_first_playable(const HandIndex* idx, Card top, Card* out);
+
+
+/**
+* @brief Number of held cards that sort before c, i.e. the index of the
+*        first copy of c in the sorted hand.
+*/
+uint32_t handindex_position(const HandIndex* idx, Card c);
+
+#endif
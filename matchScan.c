@@ -0,0 +1,314 @@
+#include <stdatomic.h>
+#include <string.h>
+#include "matchScan.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MATCH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define MATCH_X86 0
+#endif
+
+/* SSE2 is part of every x86-64 CPU; 32-bit builds must enable it */
+#if MATCH_X86 && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define MATCH_HAVE_SSE2 1
+#else
+#define MATCH_HAVE_SSE2 0
+#endif
+
+/* AVX2 is compiled per function and only called after a CPUID check */
+#if MATCH_X86 && (defined(__GNUC__) || defined(__clang__))
+#define MATCH_HAVE_AVX2 1
+#define MATCH_TARGET_AVX2 __attribute__((target("avx2")))
+#elif MATCH_X86 && defined(_MSC_VER)
+#define MATCH_HAVE_AVX2 1
+#define MATCH_TARGET_AVX2
+#else
+#define MATCH_HAVE_AVX2 0
+#endif
+
+/* one kernel: tests `width` cards starting at p, bit i set if p[i] matches.
+ * Arrays shorter than width go to the next narrower kernel. */
+typedef struct MatchImpl {
+    const char* name;
+    int width;
+    uint32_t (*block)(const Card* p, Card top);
+    const struct MatchImpl* narrower;
+} MatchImpl;
+
+/* ---------------- kernels ---------------- */
+
+static int matches(Card c, Card top)
+{
+    unsigned diff = (unsigned)(c.bits ^ top.bits);
+    return (diff & CARD_SUIT_MASK) == 0 || (diff & CARD_RANK_MASK) == 0;
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+static uint32_t block_scalar(const Card* p, Card top)
+{
+    uint32_t mask = 0;
+    for (int i = 0; i < 8; i++) {
+        if (matches(p[i], top))
+            mask |= 1u << i;
+    }
+    return mask;
+}
+#else
+#define BYTES(b) ((uint64_t)(b) * 0x0101010101010101ULL)
+
+/* 8 cards in one 64-bit word. A field of at most 7 bits is non-zero
+ * exactly when adding 0x7F to its byte sets the byte's high bit. */
+static uint32_t block_scalar(const Card* p, Card top)
+{
+    uint64_t v;
+    memcpy(&v, p, 8);
+    uint64_t x = v ^ BYTES(top.bits);
+    uint64_t suit_differs = ((x & BYTES(CARD_SUIT_MASK)) + BYTES(0x7F)) & BYTES(0x80);
+    uint64_t rank_differs = ((x & BYTES(CARD_RANK_MASK)) + BYTES(0x7F)) & BYTES(0x80);
+    uint64_t hit = ~(suit_differs & rank_differs) & BYTES(0x80);
+    return (uint32_t)(((hit >> 7) * 0x0102040810204080ULL) >> 56);   /* gather high bits */
+}
+#endif
+
+#if MATCH_HAVE_SSE2
+/* xor with the top card leaves a field zero exactly where it matches */
+static uint32_t block_sse2(const Card* p, Card top)
+{
+    __m128i v = _mm_loadu_si128((const __m128i*)p);
+    __m128i x = _mm_xor_si128(v, _mm_set1_epi8((char)top.bits));
+    __m128i zero = _mm_setzero_si128();
+    __m128i suit = _mm_cmpeq_epi8(_mm_and_si128(x, _mm_set1_epi8(CARD_SUIT_MASK)), zero);
+    __m128i rank = _mm_cmpeq_epi8(_mm_and_si128(x, _mm_set1_epi8(CARD_RANK_MASK)), zero);
+    return (uint32_t)_mm_movemask_epi8(_mm_or_si128(suit, rank));
+}
+#endif
+
+#if MATCH_HAVE_AVX2
+MATCH_TARGET_AVX2
+static uint32_t block_avx2(const Card* p, Card top)
+{
+    __m256i v = _mm256_loadu_si256((const __m256i*)p);
+    __m256i x = _mm256_xor_si256(v, _mm256_set1_epi8((char)top.bits));
+    __m256i zero = _mm256_setzero_si256();
+    __m256i suit = _mm256_cmpeq_epi8(_mm256_and_si256(x, _mm256_set1_epi8(CARD_SUIT_MASK)), zero);
+    __m256i rank = _mm256_cmpeq_epi8(_mm256_and_si256(x, _mm256_set1_epi8(CARD_RANK_MASK)), zero);
+    return (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(suit, rank));
+}
+#endif
+
+static const MatchImpl impl_scalar = { "scalar", 8, block_scalar, NULL };
+#if MATCH_HAVE_SSE2
+static const MatchImpl impl_sse2 = { "sse2", 16, block_sse2, &impl_scalar };
+#endif
+#if MATCH_HAVE_AVX2 && MATCH_HAVE_SSE2
+static const MatchImpl impl_avx2 = { "avx2", 32, block_avx2, &impl_sse2 };
+#elif MATCH_HAVE_AVX2
+static const MatchImpl impl_avx2 = { "avx2", 32, block_avx2, &impl_scalar };
+#endif
+
+/* ---------------- selection ---------------- */
+
+/* AVX2 needs CPU support and the OS saving the ymm registers */
+static int cpu_has_avx2(void)
+{
+#if MATCH_HAVE_AVX2 && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#elif MATCH_HAVE_AVX2 && defined(_MSC_VER)
+    int r[4];
+    __cpuid(r, 0);
+    if (r[0] < 7)
+        return 0;
+    __cpuid(r, 1);
+    if (!(r[2] & (1 << 27)) || !(r[2] & (1 << 28)))
+        return 0;   /* no OSXSAVE or no AVX */
+    if ((_xgetbv(0) & 6) != 6)
+        return 0;   /* OS does not save ymm state */
+    __cpuidex(r, 7, 0);
+    return (r[1] >> 5) & 1;
+#else
+    return 0;
+#endif
+}
+
+static const MatchImpl* best_impl(void)
+{
+#if MATCH_HAVE_AVX2
+    if (cpu_has_avx2())
+        return &impl_avx2;
+#endif
+#if MATCH_HAVE_SSE2
+    return &impl_sse2;
+#else
+    return &impl_scalar;
+#endif
+}
+
+static _Atomic(const MatchImpl*) current_impl;
+
+/* resolve on first use; racing threads all store the same answer */
+static const MatchImpl* impl(void)
+{
+    const MatchImpl* k = atomic_load_explicit(&current_impl, memory_order_acquire);
+    if (!k) {
+        k = best_impl();
+        atomic_store_explicit(&current_impl, k, memory_order_release);
+    }
+    return k;
+}
+
+/* Force a kernel, if this build and CPU have it */
+int match_select(MatchKernel kernel)
+{
+    const MatchImpl* k = NULL;
+
+    switch (kernel) {
+    case MATCH_KERNEL_AUTO:
+        k = best_impl();
+        break;
+    case MATCH_KERNEL_SCALAR:
+        k = &impl_scalar;
+        break;
+    case MATCH_KERNEL_SSE2:
+#if MATCH_HAVE_SSE2
+        k = &impl_sse2;
+#endif
+        break;
+    case MATCH_KERNEL_AVX2:
+#if MATCH_HAVE_AVX2
+        if (cpu_has_avx2())
+            k = &impl_avx2;
+#endif
+        break;
+    }
+
+    if (!k)
+        return 0;
+    atomic_store_explicit(&current_impl, k, memory_order_release);
+    return 1;
+}
+
+/* Name of the kernel in use */
+const char* match_kernel_name(void)
+{
+    return impl()->name;
+}
+
+/* ---------------- scans ---------------- */
+
+/* mask for cards[i .. i + width) clipped to count. Nothing is read past
+ * the array: a short tail re-reads the last full block and shifts the
+ * cards already seen out, and an array shorter than one block drops to a
+ * narrower kernel, down to a plain loop under 8 cards. */
+static uint32_t scan_block(const MatchImpl* k, const Card* cards, int count, int i, Card top)
+{
+    int n = count - i;
+    if (n >= k->width)
+        return k->block(cards + i, top);
+    if (count >= k->width)
+        return k->block(cards + count - k->width, top) >> (k->width - n);
+
+    uint32_t mask = 0;
+    while (k && count < k->width)
+        k = k->narrower;
+    if (k) {
+        for (int j = 0; j < n; j += k->width)
+            mask |= scan_block(k, cards, count, i + j, top) << j;
+        return mask;
+    }
+
+    for (int j = 0; j < n; j++) {
+        if (matches(cards[i + j], top))
+            mask |= 1u << j;
+    }
+    return mask;
+}
+
+static int lowest_index(uint32_t m)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(m);
+#elif defined(_MSC_VER)
+    unsigned long i;
+    _BitScanForward(&i, m);
+    return (int)i;
+#else
+    int i = 0;
+    while (!(m & 1)) {
+        m >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+static int popcount32(uint32_t m)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcount(m);
+#else
+    int n = 0;
+    while (m) {
+        m &= m - 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/* First matching index, or -1 */
+int match_first(const Card* cards, int count, Card top)
+{
+    const MatchImpl* k = impl();
+
+    for (int i = 0; i < count; i += k->width) {
+        uint32_t m = scan_block(k, cards, count, i, top);
+        if (m)
+            return i + lowest_index(m);
+    }
+    return -1;
+}
+
+/* Number of matching cards */
+int match_count(const Card* cards, int count, Card top)
+{
+    const MatchImpl* k = impl();
+    int n = 0;
+
+    for (int i = 0; i < count; i += k->width)
+        n += popcount32(scan_block(k, cards, count, i, top));
+    return n;
+}
+
+/* Every matching index, in order */
+int match_all(const Card* cards, int count, Card top, int* out)
+{
+    const MatchImpl* k = impl();
+    int n = 0;
+
+    for (int i = 0; i < count; i += k->width) {
+        uint32_t m = scan_block(k, cards, count, i, top);
+        while (m) {
+            out[n++] = i + lowest_index(m);
+            m &= m - 1;
+        }
+    }
+    return n;
+}
+
+/* Match bits for the first 32 cards */
+uint32_t match_mask32(const Card* cards, int count, Card top)
+{
+    const MatchImpl* k = impl();
+    uint32_t mask = 0;
+
+    if (count > 32)
+        count = 32;
+    for (int i = 0; i < count; i += k->width)
+        mask |= scan_block(k, cards, count, i, top) << i;
+    return mask;
+}
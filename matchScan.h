@@ -0,0 +1,71 @@
+/**
+* @file matchScan.h
+* @brief Vectorized "which cards can be played on top" scans over card arrays.
+*
+* A card is playable when it shares the top card's suit or rank (see
+* card_matches()). Because cards are packed bytes, one SIMD compare tests
+* 16 (SSE2) or 32 (AVX2) cards at once; a scalar loop covers every other
+* target. The kernel is picked once, at first use, from what the CPU
+* supports, and can be forced with match_select() for testing and
+* benchmarks. All functions are safe to call from several threads.
+*/
+#ifndef MATCHSCAN_H
+#define MATCHSCAN_H
+
+#include <stdint.h>
+#include "Card.h"
+
+
+/**
+* @brief Kernels match_select() can choose between.
+*/
+typedef enum {
+	MATCH_KERNEL_AUTO, // Best one the CPU supports
+	MATCH_KERNEL_SCALAR, // One card at a time, any CPU
+	MATCH_KERNEL_SSE2, // 16 cards per compare, x86
+	MATCH_KERNEL_AVX2 // 32 cards per compare, x86 with AVX2
+} MatchKernel;
+
+
+/**
+* @brief Use a specific kernel from now on.
+* @return 1 if the kernel is available on this build and CPU, 0 if not
+*         (the current kernel is kept).
+*/
+int match_select(MatchKernel kernel);
+
+
+/**
+* @brief Name of the kernel in use: "scalar", "sse2" or "avx2".
+*/
+const char* match_kernel_name(void);
+
+
+/**
+* @brief Index of the first card in cards[0..count) that matches top.
+* @return The index, or -1 if none matches.
+*/
+int match_first(const Card* cards, int count, Card top);
+
+
+/**
+* @brief Number of cards in cards[0..count) that match top.
+*/
+int match_count(const Card* cards, int count, Card top);
+
+
+/**
+* @brief Write the index of every card that matches top, in order.
+* @param out Room for up to count indices.
+* @return Number of indices written.
+*/
+int match_all(const Card* cards, int count, Card top, int* out);
+
+
+/**
+* @brief Bit i is set when cards[i] matches top, for the first 32 cards.
+* @details Cards past count (or past 32) contribute no bits.
+*/
+uint32_t match_mask32(const Card* cards, int count, Card top);
+
+#endif
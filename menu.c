@@ -1,204 +1,441 @@
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
-#include "Card.h"
-#include "CardDeck.h"
-
- /* pause function */
-void wait_for_enter(void)
+#include "game.h"
+#include "perf.h"
+#include "replay.h"
+#include "gameBatch.h"
+#include "simulator.h"
+#include "snapshot.h"
+#include "strategy.h"
+#include "transTable.h"
+
+#if !defined(_MSC_VER)
+#define scanf_s scanf  /* bounds-checked variant is MSVC-only; %lld needs no size */
+#endif
+
+/* command-line help for batch mode */
+void print_usage(const char* prog)
 {
-    printf("Press ENTER to continue...");
-    while (getchar() != '\n')
-        ;
+    fprintf(stderr,
+        "usage: %s                 interactive game\n"
+        "       %s --batch [--packs N] [--games N] [--seed N] [--verbosity 0|1|2]\n"
+        "                  [--threads N] [--log FILE] [--shoe] [--perf FILE]\n"
+        "                  [--p1 NAME] [--p2 NAME] [--lanes N] [--tt MB]\n"
+        "                  [--snapshot FILE [--turns N] | --resume FILE]\n"
+        "       %s --replay FILE\n"
+        "  --packs      packs in the deck (default 1)\n"
+        "  --shoe       draw from a virtual shoe of card counts: any pack count\n"
+        "               in constant memory\n"
+        "  --games      games to play (default 1)\n"
+        "  --seed       RNG seed (default: current time)\n"
+        "  --verbosity  0 silent, 1 one line per game (default), 2 every turn\n"
+        "  --threads    simulate on N worker threads (0 = one per CPU) and print\n"
+        "               only aggregate statistics\n"
+        "  --lanes      with --threads, step N games at once per worker in a\n"
+        "               structure-of-arrays batch (up to %d packs)\n"
+        "  --log        append every game to a binary replay log\n"
+        "  --replay     replay every game in a log and check it ends as logged\n"
+        "  --p1, --p2   player for seat 1 or 2: greedy, random, expectimax or mcts\n"
+        "               (default: the built-in first-match policy)\n"
+        "  --tt         give expectimax players a shared MB-megabyte transposition\n"
+        "               table\n"
+        "  --snapshot   play one game for --turns N turns (default 0: just the\n"
+        "               deal), save it to FILE and stop\n"
+        "  --resume     play out the game saved in FILE; packs and --shoe come\n"
+        "               from the file\n"
+        "  --perf       write hot-path counters as JSON to FILE (- for stdout);\n"
+        "               counts need a build with -DPERF_COUNTERS\n",
+        prog, prog, prog, BATCH_MAX_PACKS);
 }
 
-/* display a player's hand */
-void print_player_hand(int player_num, CardDeck* player)
+/* a whole-number option in min..max; 0 (after saying why) if it is not */
+int parse_count(const char* name, const char* val, long long min, long long max, long long* out)
 {
-    printf("Player %d's cards:\n", player_num);
-    for (int i = 0; i < player->size; i++) {
-        card_print(player->cards[i], 1);
+    char* end;
+    long long n = strtoll(val, &end, 10);
+
+    if (end == val || *end != '\0' || n < min || n > max) {
+        fprintf(stderr, "%s takes a whole number from %lld to %lld.\n", name, min, max);
+        return 0;
     }
-    printf("\n");
+    *out = n;
+    return 1;
 }
 
-/* first matching card index, or -1 */
-int find_matching_card(CardDeck* p, Card top)
+/* multi-threaded batch: merged statistics only */
+int run_simulation(int64_t packs, int use_shoe, uint64_t games, uint64_t seed, int threads, int lanes)
 {
-    for (int i = 0; i < p->size; i++) {
-        if (card_matches(p->cards[i], top))
-            return i;
+    SimConfig cfg = { 0 };
+    SimStats stats;
+
+    cfg.packs = packs;
+    cfg.use_shoe = use_shoe;
+    cfg.games = games;
+    cfg.seed = seed;
+    cfg.threads = threads;
+    cfg.lanes = lanes;
+
+    if (sim_run(&cfg, &stats) != 0) {
+        fprintf(stderr, "Simulation failed to start.\n");
+        return 1;
     }
-    return -1;
+    if (stats.games == 0)
+        return 0;
+
+    printf("games=%llu p1_wins=%.4f p2_wins=%.4f stalemates=%.4f\n",
+        (unsigned long long)stats.games,
+        (double)stats.wins[1] / (double)stats.games,
+        (double)stats.wins[2] / (double)stats.games,
+        (double)stats.wins[0] / (double)stats.games);
+    printf("turns mean=%.2f p50=%d p90=%d p99=%d\n",
+        (double)stats.turns / (double)stats.games,
+        sim_stats_turn_quantile(&stats, 0.50),
+        sim_stats_turn_quantile(&stats, 0.90),
+        sim_stats_turn_quantile(&stats, 0.99));
+    printf("refills mean=%.3f max=%llu\n",
+        (double)stats.refills / (double)stats.games,
+        (unsigned long long)stats.max_refills);
+    return 0;
 }
 
-/* move played card to played deck and display */
-void play_card(int player_num, CardDeck* player, CardDeck* played, int index)
+/* dump every thread's counters as JSON */
+int write_perf(const char* path)
 {
-    Card c;
-    carddeck_remove_at(player, index, &c);
-    carddeck_push_top(played, c);
+    PerfSnapshot snap;
+    FILE* out = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    int rc;
 
-    printf("Player %d played %s\n", player_num, card_to_string(c));
-    print_player_hand(player_num, player);
+    if (!out) {
+        fprintf(stderr, "Cannot open %s.\n", path);
+        return 1;
+    }
+    perf_snapshot(&snap);
+    rc = perf_write_json(&snap, out);
+    if (out != stdout && fclose(out) != 0)
+        rc = -1;
+    if (rc != 0) {
+        fprintf(stderr, "Writing counters to %s failed.\n", path);
+        return 1;
+    }
+    return 0;
 }
 
-/* handle drawing a card */
-void draw_card(int player_num, CardDeck* hidden, CardDeck* player)
+/* one turn: the seat's strategy if it has one, else the built-in policy */
+int take_turn(Game* game, const Strategy* const players[2], Rng* rng)
 {
-    Card drawn;
-
-    carddeck_pop_top(hidden, &drawn);
-    printf("Player %d picks %s from hidden deck.\n", player_num, card_to_string(drawn));
-
-    carddeck_push_top(player, drawn);
-    carddeck_sort(player);
-
-    print_player_hand(player_num, player);
+    const Strategy* st = players[game->turn - 1];
+    int more = st ? game_apply(game, strategy_game_move(st, game, rng)) : -1;
+    return more >= 0 ? more : game_step(game);
 }
 
-/* refill hidden deck when empty */
-void refill_if_needed(CardDeck* hidden, CardDeck* played)
+/* play one game, logging the deal and every move if there is a log */
+int play_one_game(Game* game, int64_t packs, const Strategy* const players[2], Rng* rng, ReplayWriter* log)
 {
-    if (!carddeck_is_empty(hidden))
-        return;
-
-    printf("\n*** Hidden deck empty — refilling and shuffling ***\n");
-
-    /* last played card stays */
-    Card last;
-    carddeck_pop_top(played, &last);
-
-    CardDeck temp;
-    carddeck_init(&temp);
+    Rng before = game->rng;
+    int more;
+
+    game_start(game, packs);
+    if (log)
+        replay_write_start(log, &before, game);
+    do {
+        more = take_turn(game, players, rng);
+        if (log)
+            replay_write_move(log, game->last_move);
+    } while (more);
+    if (log)
+        replay_write_end(log, game);
+
+    game_free(game);
+    return game->winner;
+}
 
-    Card c;
-    while (carddeck_pop_top(played, &c)) {
-        carddeck_push_top(&temp, c);
+/* deal one game, play up to turns turns of it and save it for --resume */
+int save_snapshot(Game* game, int64_t packs, int turns, const Strategy* const players[2], Rng* rng, const char* path)
+{
+    int more = 1;
+    int rc;
+
+    game_start(game, packs);
+    while (more && game->turns < turns)
+        more = take_turn(game, players, rng);
+    rc = snapshot_save_game(path, game);
+    game_free(game);
+
+    if (rc != SNAPSHOT_OK) {
+        fprintf(stderr, "Writing snapshot %s failed.\n", path);
+        return 1;
     }
+    printf("saved turns=%d over=%d\n", game->turns, game->over);
+    return 0;
+}
 
-    /* temp now contains all played cards except last */
-    carddeck_shuffle(&temp);
+/* load a game saved by save_snapshot() and play it to the end; -1 on error */
+int resume_snapshot(Game* game, const Strategy* const players[2], Rng* rng, const char* path)
+{
+    Snapshot snap;
+    int rc = snapshot_open(&snap, path, 1);
+    int more;
 
-    /* move shuffled back to hidden */
-    while (!carddeck_is_empty(&temp)) {
-        carddeck_pop_top(&temp, &c);
-        carddeck_push_top(hidden, c);
+    if (rc == SNAPSHOT_OK) {
+        rc = snapshot_load_game(&snap, game);   /* copies out of the mapping */
+        snapshot_close(&snap);
+    }
+    if (rc != SNAPSHOT_OK) {
+        fprintf(stderr, "Cannot load snapshot %s.\n", path);
+        return -1;
     }
 
-    /* restore last card to played deck */
-    carddeck_push_top(played, last);
-
-    carddeck_free(&temp);
+    more = !game->over;
+    while (more)
+        more = take_turn(game, players, rng);
+    game_free(game);
+    return game->winner;
 }
 
-/* ---------------- MAIN GAME LOOP ---------------- */
+/* verify every game in a replay log */
 
-int main(void)
+int run_replay(const char* path)
 {
-    CardDeck hidden, played, p1, p2;
-    int packs;
-
-    carddeck_init(&hidden);
-    carddeck_init(&played);
-    carddeck_init(&p1);
-    carddeck_init(&p2);
-
-    printf("Enter number of packs (each 52 cards): ");
-    scanf_s("%d", &packs);
-
-    while (getchar() != '\n');  /* clear input buffer */
-
-    /* create ordered deck */
-    carddeck_init_packs(&hidden, packs);
+    ReplayReader reader;
+    ReplayGame rg;
+    long long games = 0, failed = 0;
+    int rc;
+
+    if (replay_reader_open(&reader, path) != REPLAY_OK) {
+        fprintf(stderr, "Cannot read replay log %s.\n", path);
+        return 1;
+    }
 
-    /* shuffle */
-    printf("\nShuffling deck...\n");
-    carddeck_shuffle(&hidden);
+    replay_game_init(&rg);
+    while ((rc = replay_read_game(&reader, &rg)) == 1) {
+        games++;
+        if (replay_verify(&rg, 0) != REPLAY_OK) {
+            if (failed++ == 0)
+                printf("first mismatch: game=%lld\n", games);
+        }
+    }
+    replay_game_free(&rg);
+    replay_reader_close(&reader);
 
-    /* deal 8 cards each, alternating */
-    printf("Dealing cards...\n");
-    for (int i = 0; i < 8; i++) {
-        Card c1, c2;
-        carddeck_pop_top(&hidden, &c1);
-        carddeck_push_top(&p1, c1);
+    printf("replayed=%lld ok=%lld failed=%lld\n", games, games - failed, failed);
+    if (rc < 0)
+        fprintf(stderr, "Replay log is truncated or damaged after game %lld.\n", games);
+    return (failed || rc < 0) ? 1 : 0;
+}
 
-        carddeck_pop_top(&hidden, &c2);
-        carddeck_push_top(&p2, c2);
+int main(int argc, char* argv[])
+{
+    Game game;
+    long long packs = 1;
+    long long games = 1;
+    uint64_t seed = (uint64_t)time(NULL);
+    int batch = 0;
+    int threads = -1;
+    int lanes = 0;
+    long long tt_mb = 0;
+    long long snapshot_turns = 0;
+    int packs_given = 0;
+    const char* log_path = NULL;
+    const char* perf_path = NULL;
+    const char* snapshot_path = NULL;
+    const char* resume_path = NULL;
+    const Strategy* players[2] = { NULL, NULL };
+    Strategy searchers[2];
+    TransTable tt;
+    Rng strategy_rng;
+    ReplayWriter* log = NULL;
+
+    game.verbosity = VERBOSITY_SUMMARY;
+    game.interactive = 0;
+    game.use_shoe = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        long long count = 0;
+        int ok = 1;
+
+        if (strcmp(arg, "--batch") == 0) {
+            batch = 1;
+            continue;
+        }
+        if (strcmp(arg, "--shoe") == 0) {
+            game.use_shoe = 1;
+            continue;
+        }
+        if (!val) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(arg, "--packs") == 0) {
+            packs = atoll(val);
+            packs_given = 1;
+        }
+        else if (strcmp(arg, "--games") == 0)
+            ok = parse_count(arg, val, 1, LLONG_MAX, &games);
+        else if (strcmp(arg, "--seed") == 0)
+            seed = strtoull(val, NULL, 10);
+        else if (strcmp(arg, "--verbosity") == 0)
+            game.verbosity = atoi(val);
+        else if (strcmp(arg, "--threads") == 0) {
+            ok = parse_count(arg, val, 0, INT_MAX, &count);   /* 0: one per CPU */
+            threads = (int)count;
+        }
+        else if (strcmp(arg, "--lanes") == 0) {
+            ok = parse_count(arg, val, 1, INT_MAX, &count);
+            lanes = (int)count;
+        }
+        else if (strcmp(arg, "--tt") == 0)
+            tt_mb = atoll(val);
+        else if (strcmp(arg, "--log") == 0)
+            log_path = val;
+        else if (strcmp(arg, "--perf") == 0)
+            perf_path = val;
+        else if (strcmp(arg, "--snapshot") == 0)
+            snapshot_path = val;
+        else if (strcmp(arg, "--turns") == 0)
+            snapshot_turns = atoll(val);
+        else if (strcmp(arg, "--resume") == 0)
+            resume_path = val;
+        else if (strcmp(arg, "--p1") == 0 || strcmp(arg, "--p2") == 0) {
+            const Strategy* st = strategy_find(val);
+            if (!st) {
+                fprintf(stderr, "Unknown player %s.\n", val);
+                return 1;
+            }
+            players[arg[3] - '1'] = st;
+        }
+        else if (strcmp(arg, "--replay") == 0)
+            return run_replay(val);
+        else
+            ok = 0;
+        if (!ok) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        i++;
     }
 
-    /* sort hands */
-    carddeck_sort(&p1);
-    carddeck_sort(&p2);
-
-    /* print hands */
-    print_player_hand(1, &p1);
-    print_player_hand(2, &p2);
+    if ((snapshot_path || resume_path)
+        && (!batch || threads >= 0 || log_path || games != 1 || (snapshot_path && resume_path))) {
+        fprintf(stderr, "--snapshot and --resume play one game: use one of them with --batch,\n"
+            "and not with --threads, --log or --games.\n");
+        return 1;
+    }
+    if (snapshot_turns < 0 || snapshot_turns > INT_MAX || (snapshot_turns && !snapshot_path)) {
+        fprintf(stderr, "--turns takes 0 to %d turns and needs --snapshot.\n", INT_MAX);
+        return 1;
+    }
+    if (resume_path && (packs_given || game.use_shoe)) {
+        fprintf(stderr, "--resume takes packs and --shoe from the snapshot.\n");
+        return 1;
+    }
 
-    wait_for_enter();
+    if (!batch) {
+        /* classic interactive game: narrate everything, pause each turn */
+        game.verbosity = VERBOSITY_TURNS;
+        game.interactive = 1;
 
-    /* start game */
-    printf("Starting game...\n");
+        printf("Enter number of packs (each 52 cards): ");
+        scanf_s("%lld", &packs);
 
-    /* flip top card to start played pile */
-    Card top;
-    carddeck_pop_top(&hidden, &top);
-    carddeck_push_top(&played, top);
-    printf("Initial card: %s\n\n", card_to_string(top));
+        while (getchar() != '\n');  /* clear input buffer */
+    }
 
-    wait_for_enter();
+    if (packs < 1) {
+        fprintf(stderr, "Need at least one pack.\n");
+        return 1;
+    }
 
-    /* game loop */
-    int turn = 1;
+    if (lanes > 0 && !(batch && threads >= 0)) {
+        fprintf(stderr, "--lanes needs --batch and --threads.\n");
+        return 1;
+    }
 
-    while (1) {
-        Card current_top = played.cards[played.size - 1];
-        int index;
+    if (batch && threads >= 0) {
+        if (players[0] || players[1]) {
+            fprintf(stderr, "--p1 and --p2 cannot be used with --threads.\n");
+            return 1;
+        }
+        if (log_path) {
+            fprintf(stderr, "--log cannot be used with --threads.\n");
+            return 1;
+        }
+        if (tt_mb > 0) {
+            fprintf(stderr, "--tt cannot be used with --threads.\n");
+            return 1;
+        }
+        if (lanes > 0 && packs > BATCH_MAX_PACKS) {
+            fprintf(stderr, "--lanes takes at most %d packs.\n", BATCH_MAX_PACKS);
+            return 1;
+        }
+        int rc = run_simulation(packs, game.use_shoe, (uint64_t)games, seed, threads, lanes);
+        return perf_path && write_perf(perf_path) ? 1 : rc;
+    }
 
-        if (turn == 1) {
-            printf("\n--- Player 1's turn ---\n");
-            index = find_matching_card(&p1, current_top);
+    rng_seed(&game.rng, seed);
+    rng_seed_stream(&strategy_rng, seed, 1);   /* players never disturb the deal */
 
-            if (index >= 0)
-                play_card(1, &p1, &played, index);
-            else {
-                printf("Player 1 cannot play.\n");
-                draw_card(1, &hidden, &p1);
+    if (tt_mb > 0) {
+        if (tt_init(&tt, (size_t)tt_mb << 20, TT_REPLACE_DEPTH) != 0) {
+            fprintf(stderr, "Cannot allocate a %lld MB transposition table.\n", tt_mb);
+            return 1;
+        }
+        /* the built-ins are const: searching seats get a copy that points at the table */
+        for (int p = 0; p < 2; p++) {
+            if (players[p] == &strategy_expectimax) {
+                searchers[p] = strategy_expectimax;
+                searchers[p].ctx = &tt;
+                players[p] = &searchers[p];
             }
+        }
+    }
 
-            if (p1.size == 0) {
-                printf("Player 1 wins!\n");
-                break;
-            }
+    if (log_path) {
+        log = malloc(sizeof(*log));     /* holds a 64 KiB buffer */
+        if (!log || replay_writer_open(log, log_path) != REPLAY_OK) {
+            fprintf(stderr, "Cannot open replay log %s.\n", log_path);
+            return 1;
         }
-        else {
-            printf("\n--- Player 2's turn ---\n");
-            index = find_matching_card(&p2, current_top);
+    }
 
-            if (index >= 0)
-                play_card(2, &p2, &played, index);
-            else {
-                printf("Player 2 cannot play.\n");
-                draw_card(2, &hidden, &p2);
-            }
+    int rc = 0;
+    if (snapshot_path)
+        rc = save_snapshot(&game, packs, (int)snapshot_turns, players, &strategy_rng, snapshot_path);
+    else if (resume_path) {
+        int winner = resume_snapshot(&game, players, &strategy_rng, resume_path);
+        if (winner < 0)
+            rc = 1;
+        else if (game.verbosity >= VERBOSITY_SUMMARY)
+            printf("game=1 winner=%d turns=%d refills=%d\n", winner, game.turns, game.refills);
+    }
+    else {
+        for (long long n = 1; n <= games; n++) {
+            int winner = play_one_game(&game, packs, players, &strategy_rng, log);
 
-            if (p2.size == 0) {
-                printf("Player 2 wins!\n");
-                break;
-            }
+            if (batch && game.verbosity >= VERBOSITY_SUMMARY)
+                printf("game=%lld winner=%d turns=%d refills=%d\n",
+                    n, winner, game.turns, game.refills);
         }
+    }
 
-        refill_if_needed(&hidden, &played);
+    if (tt_mb > 0)
+        tt_free(&tt);
 
-        wait_for_enter();
-        turn = (turn == 1 ? 2 : 1);
+    if (log) {
+        if (replay_writer_close(log) != REPLAY_OK) {
+            fprintf(stderr, "Writing replay log %s failed.\n", log_path);
+            rc = 1;
+        }
+        free(log);
     }
 
-    /* cleanup */
-    carddeck_free(&hidden);
-    carddeck_free(&played);
-    carddeck_free(&p1);
-    carddeck_free(&p2);
+    if (perf_path && write_perf(perf_path))
+        return 1;
 
-    return 0;
+    return rc;
 }
+
@@ -0,0 +1,132 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "perf.h"
+
+_Thread_local PerfBlock* perf_local;
+
+/* every block ever registered; only ever pushed onto */
+static _Atomic(PerfBlock*) perf_blocks;
+
+static const char* const counter_names[PERF_COUNTER_COUNT] = {
+    "node_alloc", "node_free", "nodes_traversed", "deck_realloc",
+    "refill_cards", "sorts", "shuffles", "turns", "tt_probes", "tt_hits"
+};
+
+static const char* const hist_names[PERF_HIST_COUNT] = { "turn", "shuffle", "sort" };
+
+/* Give this thread a block */
+PerfBlock* perf_register(void)
+{
+    PerfBlock* b = calloc(1, sizeof(*b));
+    if (!b) {
+        fprintf(stderr, "Memory allocation failed in perf_register()\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* lock-free push: retry until nobody else pushed in between */
+    PerfBlock* head = atomic_load(&perf_blocks);
+    do {
+        b->next = head;
+    } while (!atomic_compare_exchange_weak(&perf_blocks, &head, b));
+
+    perf_local = b;
+    return b;
+}
+
+/* Monotonic nanoseconds */
+uint64_t perf_now_ns(void)
+{
+    struct timespec ts;
+#if defined(CLOCK_MONOTONIC)
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+    timespec_get(&ts, TIME_UTC);
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* single writer per block, so a relaxed load and store is enough */
+static void bump(_Atomic uint64_t* c, uint64_t n)
+{
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+/* Add one latency to a log2 histogram */
+void perf_record(PerfHist hist, uint64_t ns)
+{
+    PerfBlock* b = perf_local ? perf_local : perf_register();
+    int bucket = 0;
+
+    for (uint64_t v = ns; v > 1 && bucket < PERF_HIST_BUCKETS - 1; v >>= 1)
+        bucket++;
+    bump(&b->hist[hist][bucket], 1);
+    bump(&b->histNs[hist], ns);
+}
+
+/* Sum all blocks */
+void perf_snapshot(PerfSnapshot* out)
+{
+    memset(out, 0, sizeof(*out));
+#if defined(PERF_COUNTERS)
+    out->enabled = 1;
+#endif
+
+    for (PerfBlock* b = atomic_load(&perf_blocks); b; b = b->next) {
+        out->threads++;
+        for (int c = 0; c < PERF_COUNTER_COUNT; c++)
+            out->counters[c] += atomic_load_explicit(&b->counters[c], memory_order_relaxed);
+        for (int h = 0; h < PERF_HIST_COUNT; h++) {
+            for (int i = 0; i < PERF_HIST_BUCKETS; i++)
+                out->hist[h][i] += atomic_load_explicit(&b->hist[h][i], memory_order_relaxed);
+            out->histNs[h] += atomic_load_explicit(&b->histNs[h], memory_order_relaxed);
+        }
+    }
+}
+
+/* Zero all blocks */
+void perf_reset(void)
+{
+    for (PerfBlock* b = atomic_load(&perf_blocks); b; b = b->next) {
+        for (int c = 0; c < PERF_COUNTER_COUNT; c++)
+            atomic_store_explicit(&b->counters[c], 0, memory_order_relaxed);
+        for (int h = 0; h < PERF_HIST_COUNT; h++) {
+            for (int i = 0; i < PERF_HIST_BUCKETS; i++)
+                atomic_store_explicit(&b->hist[h][i], 0, memory_order_relaxed);
+            atomic_store_explicit(&b->histNs[h], 0, memory_order_relaxed);
+        }
+    }
+}
+
+/* One JSON object: counters, derived ratios, histograms (bucket i starts at 2^i ns) */
+int perf_write_json(const PerfSnapshot* snap, FILE* out)
+{
+    uint64_t turns = snap->counters[PERF_TURNS];
+    uint64_t probes = snap->counters[PERF_TT_PROBES];
+
+    fprintf(out, "{\"enabled\":%s,\"threads\":%d,\"counters\":{", snap->enabled ? "true" : "false", snap->threads);
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++)
+        fprintf(out, "%s\"%s\":%llu", c ? "," : "", counter_names[c], (unsigned long long)snap->counters[c]);
+
+    fprintf(out, "},\"derived\":{\"sorts_per_turn\":%.4f,\"tt_hit_rate\":%.4f},\"histograms\":{",
+        turns ? (double)snap->counters[PERF_SORTS] / (double)turns : 0.0,
+        probes ? (double)snap->counters[PERF_TT_HITS] / (double)probes : 0.0);
+    for (int h = 0; h < PERF_HIST_COUNT; h++) {
+        uint64_t count = 0;
+        for (int i = 0; i < PERF_HIST_BUCKETS; i++)
+            count += snap->hist[h][i];
+
+        fprintf(out, "%s\"%s\":{\"count\":%llu,\"total_ns\":%llu,\"mean_ns\":%.1f,\"buckets\":[",
+            h ? "," : "", hist_names[h], (unsigned long long)count, (unsigned long long)snap->histNs[h],
+            count ? (double)snap->histNs[h] / (double)count : 0.0);
+        for (int i = 0; i < PERF_HIST_BUCKETS; i++)
+            fprintf(out, "%s%llu", i ? "," : "", (unsigned long long)snap->hist[h][i]);
+        fprintf(out, "]}");
+    }
+    fprintf(out, "}}\n");
+    return ferror(out) ? -1 : 0;
+}
@@ -0,0 +1,145 @@
+/**
+* @file perf.h
+* @brief Opt-in counters and latency histograms for the deck and game hot paths.
+*
+* Build with -DPERF_COUNTERS to turn the PERF_* hooks on; without it they
+* expand to nothing and cost nothing. The functions below are always
+* there, so a front end can ask for a report either way (it then says
+* "enabled": false and every number is zero).
+*
+* Each thread counts into its own block, found through a thread-local
+* pointer and linked into a global list the first time the thread counts.
+* Only the owning thread writes a block, with relaxed atomic loads and
+* stores, so counting is a plain add and never takes a lock; perf_snapshot()
+* walks the list and sums whatever the blocks hold at that moment. Blocks
+* outlive their threads, so totals from finished simulator workers stay in
+* the report.
+*/
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define PERF_HIST_BUCKETS 40 // Bucket b holds latencies in [2^b, 2^(b+1)) ns; the last one holds the rest
+
+
+/**
+* @brief Things that are counted.
+*/
+typedef enum {
+	PERF_NODE_ALLOC, // List nodes created (createNode)
+	PERF_NODE_FREE, // List nodes released or freed with their deck
+	PERF_NODES_TRAVERSED, // List nodes walked past in addCardBottom and removeCardAt
+	PERF_DECK_REALLOC, // Card array reallocations (array and ring decks)
+	PERF_REFILL_CARDS, // Cards moved from played back to hidden by refill_if_needed
+	PERF_SORTS, // card_sort / card_sort_desc calls
+	PERF_SHUFFLES, // card_shuffle calls
+	PERF_TURNS, // Game turns played
+	PERF_TT_PROBES, // Transposition table lookups (tt_probe)
+	PERF_TT_HITS, // Lookups that found a usable entry
+	PERF_COUNTER_COUNT
+} PerfCounter;
+
+
+/**
+* @brief Things whose latency is recorded.
+*/
+typedef enum {
+	PERF_HIST_TURN, // One game turn
+	PERF_HIST_SHUFFLE, // One shuffle
+	PERF_HIST_SORT, // One sort
+	PERF_HIST_COUNT
+} PerfHist;
+
+
+/**
+* @struct PerfBlock
+* @brief One thread's counters and histograms.
+*/
+typedef struct PerfBlock {
+	_Atomic uint64_t counters[PERF_COUNTER_COUNT];
+	_Atomic uint64_t hist[PERF_HIST_COUNT][PERF_HIST_BUCKETS];
+	_Atomic uint64_t histNs[PERF_HIST_COUNT]; // Total time recorded per histogram
+	struct PerfBlock* next; // Next registered block
+} PerfBlock;
+
+
+/**
+* @struct PerfSnapshot
+* @brief Every thread's numbers added together.
+*/
+typedef struct {
+	int enabled; // 1 if built with PERF_COUNTERS
+	int threads; // Threads that have counted anything
+	uint64_t counters[PERF_COUNTER_COUNT];
+	uint64_t hist[PERF_HIST_COUNT][PERF_HIST_BUCKETS];
+	uint64_t histNs[PERF_HIST_COUNT];
+} PerfSnapshot;
+
+
+extern _Thread_local PerfBlock* perf_local; // This thread's block, NULL until it first counts
+
+
+/**
+* @brief Register a block for the calling thread and return it.
+* @details Exits the program if memory allocation fails.
+*/
+PerfBlock* perf_register(void);
+
+
+/**
+* @brief Monotonic clock in nanoseconds.
+*/
+uint64_t perf_now_ns(void);
+
+
+/**
+* @brief Add n to a counter of the calling thread.
+*/
+static inline void perf_add(PerfCounter counter, uint64_t n)
+{
+	PerfBlock* b = perf_local ? perf_local : perf_register();
+	_Atomic uint64_t* c = &b->counters[counter];
+	atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+
+/**
+* @brief Record one latency of ns nanoseconds in a histogram.
+*/
+void perf_record(PerfHist hist, uint64_t ns);
+
+
+/**
+* @brief Sum every thread's block into out.
+*/
+void perf_snapshot(PerfSnapshot* out);
+
+
+/**
+* @brief Zero every block. Counts made by other threads at the same time
+*        may survive the reset.
+*/
+void perf_reset(void);
+
+
+/**
+* @brief Write a snapshot as one JSON object followed by a newline.
+* @return 0 on success, -1 if the write failed.
+*/
+int perf_write_json(const PerfSnapshot* snap, FILE* out);
+
+
+#if defined(PERF_COUNTERS)
+#define PERF_COUNT(counter, n) perf_add((counter), (uint64_t)(n))
+#define PERF_TIMER(name) uint64_t name = perf_now_ns()
+#define PERF_RECORD(hist, name) perf_record((hist), perf_now_ns() - (name))
+#else
+#define PERF_COUNT(counter, n) ((void)0)
+#define PERF_TIMER(name) ((void)0)
+#define PERF_RECORD(hist, name) ((void)0)
+#endif
+
+#endif
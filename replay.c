@@ -0,0 +1,322 @@
+#include <stdlib.h>
+#include <string.h>
+#include "replay.h"
+
+static const unsigned char magic[8] = { 'C', 'A', 'R', 'D', 'L', 'O', 'G', '2' };
+
+#define EVENT_END 0
+#define EVENT_BASE 3    /* event = move + EVENT_BASE, so MOVE_PASS is 1, MOVE_DRAW 2 */
+
+#define FNV_OFFSET 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x100000001B3ULL
+
+/* ---------------- writer ---------------- */
+
+static void writer_flush(ReplayWriter* w)
+{
+    if (w->len && !w->failed && fwrite(w->buf, 1, w->len, w->file) != w->len)
+        w->failed = 1;
+    w->len = 0;
+}
+
+static void put_byte(ReplayWriter* w, unsigned char b)
+{
+    if (w->len == REPLAY_BUFFER)
+        writer_flush(w);
+    w->buf[w->len++] = b;
+}
+
+/* LEB128: 7 bits per byte, high bit set on all but the last */
+static void put_varint(ReplayWriter* w, uint64_t v)
+{
+    while (v >= 0x80) {
+        put_byte(w, (unsigned char)(v | 0x80));
+        v >>= 7;
+    }
+    put_byte(w, (unsigned char)v);
+}
+
+static void put_u64(ReplayWriter* w, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+        put_byte(w, (unsigned char)(v >> (8 * i)));
+}
+
+/* Open for append; new files get the magic */
+int replay_writer_open(ReplayWriter* w, const char* path)
+{
+    w->len = 0;
+    w->failed = 0;
+    w->file = fopen(path, "ab");
+    if (!w->file)
+        return REPLAY_EIO;
+
+    fseek(w->file, 0, SEEK_END);
+    if (ftell(w->file) == 0) {
+        for (size_t i = 0; i < sizeof(magic); i++)
+            put_byte(w, magic[i]);
+    }
+    return REPLAY_OK;
+}
+
+/* Game header: packs and shoe flag, starting generator, deal hash */
+void replay_write_start(ReplayWriter* w, const Rng* before, const Game* g)
+{
+    put_varint(w, (uint64_t)g->packs << 1 | (uint64_t)(g->use_shoe != 0));
+    for (int i = 0; i < 4; i++)
+        put_u64(w, before->s[i]);
+    put_u64(w, replay_deal_hash(g));
+}
+
+/* One turn */
+void replay_write_move(ReplayWriter* w, int move)
+{
+    put_varint(w, (uint64_t)(move + EVENT_BASE));
+}
+
+/* End marker and result */
+void replay_write_end(ReplayWriter* w, const Game* g)
+{
+    put_varint(w, EVENT_END);
+    put_varint(w, (uint64_t)g->winner);
+}
+
+/* Flush and close */
+int replay_writer_close(ReplayWriter* w)
+{
+    writer_flush(w);
+    if (fclose(w->file) != 0)
+        w->failed = 1;
+    w->file = NULL;
+    return w->failed ? REPLAY_EIO : REPLAY_OK;
+}
+
+/* ---------------- reader ---------------- */
+
+/* next byte, or -1 at end of file */
+static int get_byte(ReplayReader* r)
+{
+    if (r->pos == r->len) {
+        r->len = fread(r->buf, 1, REPLAY_BUFFER, r->file);
+        r->pos = 0;
+        if (r->len == 0)
+            return -1;
+    }
+    return r->buf[r->pos++];
+}
+
+/* 1 on success, 0 if the file ends or the varint runs past 64 bits */
+static int get_varint(ReplayReader* r, uint64_t* out)
+{
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int b = get_byte(r);
+        if (b < 0)
+            return 0;
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *out = v;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int get_u64(ReplayReader* r, uint64_t* out)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) {
+        int b = get_byte(r);
+        if (b < 0)
+            return 0;
+        v |= (uint64_t)b << (8 * i);
+    }
+    *out = v;
+    return 1;
+}
+
+/* Open and check the magic */
+int replay_reader_open(ReplayReader* r, const char* path)
+{
+    r->len = 0;
+    r->pos = 0;
+    r->file = fopen(path, "rb");
+    if (!r->file)
+        return REPLAY_EIO;
+
+    for (size_t i = 0; i < sizeof(magic); i++) {
+        if (get_byte(r) != magic[i]) {
+            replay_reader_close(r);
+            return REPLAY_EFORMAT;
+        }
+    }
+    return REPLAY_OK;
+}
+
+/* Close */
+void replay_reader_close(ReplayReader* r)
+{
+    if (r->file)
+        fclose(r->file);
+    r->file = NULL;
+}
+
+/* Empty game record */
+void replay_game_init(ReplayGame* rg)
+{
+    memset(rg, 0, sizeof(*rg));
+}
+
+/* Release moves */
+void replay_game_free(ReplayGame* rg)
+{
+    free(rg->moves);
+    replay_game_init(rg);
+}
+
+static void push_move(ReplayGame* rg, int move)
+{
+    if (rg->count == rg->capacity) {
+        int cap = rg->capacity ? rg->capacity * 2 : 128;
+        int* moves = realloc(rg->moves, sizeof(int) * cap);
+        if (!moves) {
+            fprintf(stderr, "Memory allocation failed in replay_read_game()\n");
+            exit(EXIT_FAILURE);
+        }
+        rg->moves = moves;
+        rg->capacity = cap;
+    }
+    rg->moves[rg->count++] = move;
+}
+
+/* Decode one game */
+int replay_read_game(ReplayReader* r, ReplayGame* rg)
+{
+    uint64_t v;
+
+    if (r->pos == r->len) {
+        int b = get_byte(r);
+        if (b < 0)
+            return 0;   /* clean end of log */
+        r->pos--;
+    }
+
+    rg->count = 0;
+    if (!get_varint(r, &v) || (v >> 1) < 1 || (v >> 1) > SHOE_MAX_PACKS)
+        return REPLAY_EFORMAT;
+    rg->packs = (int64_t)(v >> 1);
+    rg->use_shoe = (int)(v & 1);
+    for (int i = 0; i < 4; i++) {
+        if (!get_u64(r, &rg->rng.s[i]))
+            return REPLAY_EFORMAT;
+    }
+    if (!get_u64(r, &rg->deal_hash))
+        return REPLAY_EFORMAT;
+
+    while (1) {
+        if (!get_varint(r, &v) || v > 0x7FFFFFFF)
+            return REPLAY_EFORMAT;
+        if (v == EVENT_END)
+            break;
+        push_move(rg, (int)v - EVENT_BASE);
+    }
+
+    if (!get_varint(r, &v) || v > 2)
+        return REPLAY_EFORMAT;
+    rg->winner = (int)v;
+    return 1;
+}
+
+/* ---------------- engine ---------------- */
+
+static uint64_t hash_cards(uint64_t h, const Card* cards, int64_t count)
+{
+    for (int64_t i = 0; i < count; i++) {
+        h ^= cards[i].bits;
+        h *= FNV_PRIME;
+    }
+    h ^= (uint64_t)count;   /* keeps "ab|c" apart from "a|bc" */
+    h *= FNV_PRIME;
+    return h;
+}
+
+static uint64_t hash_deck(uint64_t h, const CardDeck* deck)
+{
+    Card* cards = carddeck_to_array(deck);
+    h = hash_cards(h, cards, carddeck_size(deck));
+    free(cards);
+    return h;
+}
+
+/* the shoe has no order to hash, only its counts */
+static uint64_t hash_shoe(uint64_t h, const Shoe* shoe)
+{
+    for (int k = 0; k < SHOE_KINDS; k++) {
+        h ^= shoe->count[k];
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+/* FNV-1a over hidden (or the shoe), played and both hands */
+uint64_t replay_deal_hash(const Game* g)
+{
+    uint64_t h = FNV_OFFSET;
+    h = g->use_shoe ? hash_shoe(h, &g->shoe) : hash_deck(h, &g->hidden);
+    h = hash_deck(h, &g->played);
+    for (int p = 0; p < 2; p++)
+        h = hash_cards(h, g->players[p].hand.cards, g->players[p].hand.size);
+    return h;
+}
+
+/* Deal from the logged generator and apply moves up to turn */
+int replay_seek(const ReplayGame* rg, Game* g, int turn)
+{
+    if (turn < 0 || turn > rg->count)
+        turn = rg->count;
+
+    g->rng = rg->rng;
+    g->use_shoe = rg->use_shoe;
+    game_start(g, rg->packs);
+    if (replay_deal_hash(g) != rg->deal_hash)
+        return REPLAY_EMISMATCH;
+
+    for (int i = 0; i < turn; i++) {
+        if (g->over)
+            return REPLAY_EMISMATCH;    /* log goes on after the game ended */
+        if (game_apply(g, rg->moves[i]) < 0)
+            return REPLAY_EILLEGAL;
+    }
+    return REPLAY_OK;
+}
+
+/* Full replay plus result and (optionally) policy checks */
+int replay_verify(const ReplayGame* rg, int check_policy)
+{
+    Game g;
+    int rc = REPLAY_OK;
+
+    memset(&g, 0, sizeof(g));
+    g.verbosity = VERBOSITY_QUIET;
+    g.rng = rg->rng;
+    g.use_shoe = rg->use_shoe;
+    game_start(&g, rg->packs);
+
+    if (replay_deal_hash(&g) != rg->deal_hash)
+        rc = REPLAY_EMISMATCH;
+
+    for (int i = 0; i < rg->count && rc == REPLAY_OK; i++) {
+        if (g.over)
+            rc = REPLAY_EMISMATCH;
+        else if (check_policy && game_choose_move(&g) != rg->moves[i])
+            rc = REPLAY_EMISMATCH;
+        else if (game_apply(&g, rg->moves[i]) < 0)
+            rc = REPLAY_EILLEGAL;
+    }
+
+    if (rc == REPLAY_OK && (!g.over || g.winner != rg->winner))
+        rc = REPLAY_EMISMATCH;
+
+    game_free(&g);
+    return rc;
+}
@@ -0,0 +1,164 @@
+/**
+* @file replay.h
+* @brief Compact binary game logs and a replay engine that rebuilds them.
+*
+* A log is the magic "CARDLOG2" followed by games back to back. Each game
+* is its packs times two, plus one if it drew from a shoe (varint), the
+* Rng state before game_start (4 x 8 bytes, little-endian), a hash of the
+* dealt position (8 bytes), one varint per turn, and the winner:
+*   0 end of game, followed by the winner (varint)
+*   1 pass (MOVE_PASS)
+*   2 draw (MOVE_DRAW)
+*   3 + i play the card at hand index i
+* A typical one-pack game takes about 90 bytes. Logs are append-only, so
+* several runs can write to the same file.
+*
+* Replaying deals from the saved Rng (every deck backend shuffles top first,
+* so a log replays on any of them; the hash catches a mismatch) and then
+* applies the logged moves with game_apply() instead of asking any player
+* for a decision.
+*/
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "game.h"
+
+#define REPLAY_BUFFER 65536 // Bytes buffered by readers and writers
+
+/* results; functions return REPLAY_OK or one of the negative codes */
+#define REPLAY_OK 0
+#define REPLAY_EIO (-1) // File could not be opened, read or written
+#define REPLAY_EFORMAT (-2) // Not a replay log, or truncated or damaged
+#define REPLAY_EMISMATCH (-3) // Deal or result differs from the log
+#define REPLAY_EILLEGAL (-4) // A logged move is not legal in the rebuilt game
+
+
+/**
+* @struct ReplayWriter
+* @brief Appends games to a log through its own buffer.
+*/
+typedef struct {
+	FILE* file;
+	unsigned char buf[REPLAY_BUFFER];
+	size_t len; // Bytes waiting in buf
+	int failed; // Set after any write error
+} ReplayWriter;
+
+
+/**
+* @struct ReplayReader
+* @brief Reads games from a log through its own buffer.
+*/
+typedef struct {
+	FILE* file;
+	unsigned char buf[REPLAY_BUFFER];
+	size_t len; // Bytes in buf
+	size_t pos; // Next byte to read
+} ReplayReader;
+
+
+/**
+* @struct ReplayGame
+* @brief One logged game.
+*/
+typedef struct {
+	int64_t packs;
+	int use_shoe; // 1 if the game drew from a Shoe
+	Rng rng; // Generator state before game_start
+	uint64_t deal_hash; // replay_deal_hash() right after game_start
+	int winner; // 1, 2, or 0 for a stalemate
+	int* moves; // One move per turn (hand index or MOVE_*)
+	int count; // Turns in moves
+	int capacity; // Entries allocated in moves
+} ReplayGame;
+
+
+/**
+* @brief Open a log for appending, writing the magic if it is new.
+*/
+int replay_writer_open(ReplayWriter* w, const char* path);
+
+
+/**
+* @brief Start a game record.
+* @param before Rng state the game was started with.
+* @param g The game right after game_start().
+*/
+void replay_write_start(ReplayWriter* w, const Rng* before, const Game* g);
+
+
+/**
+* @brief Log one turn; pass g->last_move after each game_step().
+*/
+void replay_write_move(ReplayWriter* w, int move);
+
+
+/**
+* @brief Finish the game record with the game's winner.
+*/
+void replay_write_end(ReplayWriter* w, const Game* g);
+
+
+/**
+* @brief Flush and close.
+* @return REPLAY_OK, or REPLAY_EIO if any write failed.
+*/
+int replay_writer_close(ReplayWriter* w);
+
+
+/**
+* @brief Open a log for reading and check its magic.
+*/
+int replay_reader_open(ReplayReader* r, const char* path);
+
+
+/**
+* @brief Close the reader.
+*/
+void replay_reader_close(ReplayReader* r);
+
+
+/**
+* @brief Initialize an empty ReplayGame.
+*/
+void replay_game_init(ReplayGame* rg);
+
+
+/**
+* @brief Free a ReplayGame's moves.
+*/
+void replay_game_free(ReplayGame* rg);
+
+
+/**
+* @brief Read the next game into rg (reusing its storage).
+* @return 1 if a game was read, 0 at the end of the log, REPLAY_EFORMAT if damaged.
+*/
+int replay_read_game(ReplayReader* r, ReplayGame* rg);
+
+
+/**
+* @brief Hash of a game's decks and hands, to check a deal is reproduced.
+*/
+uint64_t replay_deal_hash(const Game* g);
+
+
+/**
+* @brief Rebuild a logged game as it stood before turn `turn` (0-based).
+* @details turn < 0 or past the end replays the whole game. The caller
+*          owns the result and releases it with game_free(). g's verbosity
+*          and interactive settings are used as the caller left them.
+*/
+int replay_seek(const ReplayGame* rg, Game* g, int turn);
+
+
+/**
+* @brief Replay a whole game and check it ends as logged.
+* @param check_policy 1 to also require every move to be the one the
+*        built-in policy (game_choose_move) would have made.
+*/
+int replay_verify(const ReplayGame* rg, int check_policy);
+
+#endif
@@ -0,0 +1,56 @@
+#include "rng.h"
+
+/* splitmix64 step, used to spread a 64-bit seed over the 256-bit state */
+static uint64_t splitmix64(uint64_t* x)
+{
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/* Seed a generator */
+void rng_seed(Rng* rng, uint64_t seed)
+{
+    for (int i = 0; i < 4; i++) {
+        rng->s[i] = splitmix64(&seed);
+    }
+}
+
+/* Seed a generator on its own stream */
+void rng_seed_stream(Rng* rng, uint64_t seed, uint64_t stream)
+{
+    rng_seed(rng, seed);
+    while (stream-- > 0) {
+        rng_jump(rng);
+    }
+}
+
+/* Jump ahead 2^128 outputs (polynomial from the xoshiro256** reference) */
+void rng_jump(Rng* rng)
+{
+    static const uint64_t jump[] = {
+        0x180EC6D33CFD0ABAULL,
+        0xD5A61266F0C9392CULL,
+        0xA9582618E03FC9AAULL,
+        0x39ABDC4529B1661CULL
+    };
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (jump[i] & (1ULL << b)) {
+                s0 ^= rng->s[0];
+                s1 ^= rng->s[1];
+                s2 ^= rng->s[2];
+                s3 ^= rng->s[3];
+            }
+            rng_next(rng);
+        }
+    }
+
+    rng->s[0] = s0;
+    rng->s[1] = s1;
+    rng->s[2] = s2;
+    rng->s[3] = s3;
+}
@@ -0,0 +1,121 @@
+/**
+* @file rng.h
+* @brief Small, fast, seedable random number generator (xoshiro256**).
+*
+* Each Rng is a caller-owned value: there is no global state, so two
+* threads with their own generators never contend. rng_seed_stream() gives
+* non-overlapping streams from one seed, which keeps multi-threaded runs
+* reproducible.
+*/
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+
+/**
+* @struct Rng
+* @brief State of one xoshiro256** generator.
+*/
+typedef struct {
+	uint64_t s[4]; // Generator state; never all zero
+} Rng;
+
+
+/**
+* @brief Seed a generator. The same seed always gives the same sequence.
+*/
+void rng_seed(Rng* rng, uint64_t seed);
+
+
+/**
+* @brief Seed a generator on stream number `stream` of `seed`.
+*
+* Stream k starts 2^128 * k outputs after stream 0, so streams never overlap
+* in practice. Costs O(stream) jumps; meant for one call per worker.
+*/
+void rng_seed_stream(Rng* rng, uint64_t seed, uint64_t stream);
+
+
+/**
+* @brief Advance the generator by 2^128 outputs.
+*/
+void rng_jump(Rng* rng);
+
+
+/**
+* @brief Rotate left; helper for rng_next().
+*/
+static inline uint64_t rng_rotl(uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+
+/**
+* @brief Next 64 random bits.
+*/
+static inline uint64_t rng_next(Rng* rng)
+{
+	uint64_t* s = rng->s;
+	uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+	uint64_t t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rng_rotl(s[3], 45);
+	return result;
+}
+
+
+/**
+* @brief Uniform integer in [0, bound) without modulo bias.
+*
+* Multiplies 32 random bits by the bound and keeps the high half, rejecting
+* the few low halves that would make some results more likely (Lemire's
+* method). The division only happens on the rare rejection path.
+*
+* @param bound Upper limit, must be greater than 0.
+*/
+static inline uint32_t rng_bounded(Rng* rng, uint32_t bound)
+{
+	uint64_t m = (rng_next(rng) >> 32) * (uint64_t)bound;
+	uint32_t low = (uint32_t)m;
+
+	if (low < bound) {
+		uint32_t threshold = (uint32_t)(-bound) % bound;
+		while (low < threshold) {
+			m = (rng_next(rng) >> 32) * (uint64_t)bound;
+			low = (uint32_t)m;
+		}
+	}
+	return (uint32_t)(m >> 32);
+}
+
+
+/**
+* @brief Uniform integer in [0, bound) for bounds past 32 bits.
+*
+* Bounds that fit in 32 bits go through rng_bounded(), so decks of any
+* size under 2^32 cards shuffle exactly as they always have. Larger bounds
+* take the top bits of one output and reject values past the largest
+* multiple of the bound; at most half of all draws are rejected.
+*
+* @param bound Upper limit, must be greater than 0.
+*/
+static inline uint64_t rng_bounded64(Rng* rng, uint64_t bound)
+{
+	if (bound <= UINT32_MAX)
+		return rng_bounded(rng, (uint32_t)bound);
+
+	uint64_t limit = UINT64_MAX - UINT64_MAX % bound; // Largest multiple of bound
+	uint64_t x = rng_next(rng);
+	while (x >= limit)
+		x = rng_next(rng);
+	return x % bound;
+}
+
+#endif
@@ -0,0 +1,100 @@
+#include <stdlib.h>
+#include <string.h>
+#include "shoe.h"
+
+#define SHOE_TOP_STEP 32    /* highest power of two <= SHOE_KINDS */
+
+/* kind index of a card: suit-major, like a fresh pack */
+static int kind_of(Card c)
+{
+    return (int)card_suit(c) * 13 + (int)card_rank(c) - TWO;
+}
+
+static Card card_of(int kind)
+{
+    return card_create((Suit)(kind / 13), (Rank)(TWO + kind % 13));
+}
+
+/* add delta (mod 2^64, so "minus one" works) to kind's count in the tree */
+static void tree_add(Shoe* shoe, int kind, uint64_t delta)
+{
+    for (int i = kind + 1; i <= SHOE_KINDS; i += i & -i)
+        shoe->tree[i] += delta;
+}
+
+/* Empty shoe */
+void shoe_clear(Shoe* shoe)
+{
+    memset(shoe, 0, sizeof(*shoe));
+}
+
+/* packs of every kind; the tree is built in one linear pass */
+void shoe_init(Shoe* shoe, uint64_t packs)
+{
+    if (packs > SHOE_MAX_PACKS) {
+        fprintf(stderr, "Shoe of %llu packs is too large in shoe_init()\n", (unsigned long long)packs);
+        exit(EXIT_FAILURE);
+    }
+
+    shoe_clear(shoe);
+    for (int k = 0; k < SHOE_KINDS; k++) {
+        shoe->count[k] = packs;
+        shoe->tree[k + 1] += packs;
+        int parent = (k + 1) + ((k + 1) & -(k + 1));
+        if (parent <= SHOE_KINDS)
+            shoe->tree[parent] += shoe->tree[k + 1];
+    }
+    shoe->size = packs * SHOE_KINDS;
+}
+
+/* Cards left of one kind */
+uint64_t shoe_count(const Shoe* shoe, Card c)
+{
+    return shoe->count[kind_of(c)];
+}
+
+/* Return cards to the shoe */
+void shoe_add(Shoe* shoe, Card c, uint64_t n)
+{
+    if (n > UINT64_MAX - shoe->size) {
+        fprintf(stderr, "Shoe overflow in shoe_add()\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int k = kind_of(c);
+    shoe->count[k] += n;
+    shoe->size += n;
+    tree_add(shoe, k, n);
+}
+
+/* pick r in [0, size) and walk the tree down to the kind holding the r-th card */
+int shoe_draw(Shoe* shoe, Rng* rng, Card* out)
+{
+    if (shoe->size == 0)
+        return 0;
+
+    uint64_t r = rng_bounded64(rng, shoe->size);
+    int pos = 0;
+    for (int step = SHOE_TOP_STEP; step > 0; step >>= 1) {
+        if (pos + step <= SHOE_KINDS && shoe->tree[pos + step] <= r) {
+            pos += step;
+            r -= shoe->tree[pos];
+        }
+    }
+
+    shoe->count[pos]--;
+    shoe->size--;
+    tree_add(shoe, pos, (uint64_t)-1);
+    *out = card_of(pos);
+    return 1;
+}
+
+/* Several draws at once */
+int shoe_deal(Shoe* shoe, Rng* rng, Card* out, int64_t count)
+{
+    if (count < 0 || (uint64_t)count > shoe->size)
+        return 0;
+    for (int64_t i = 0; i < count; i++)
+        shoe_draw(shoe, rng, &out[i]);
+    return 1;
+}
@@ -0,0 +1,98 @@
+/**
+* @file shoe.h
+* @brief A draw pile of any number of packs kept as 52 card counts.
+*
+* A shuffled N-pack deck popped from the top hands out a uniformly random
+* ordering of its cards. The same sequence comes from picking, at every
+* draw, one of the remaining cards uniformly at random, so the shoe never
+* materializes the cards at all: it keeps how many of each of the 52 cards
+* are left and draws card k with probability count[k] / size. A Fenwick
+* tree over the counts finds the drawn card in 6 steps and updates in 6
+* more. Memory is a fixed ~850 bytes whatever the pack count, and counts
+* are 64-bit, so the shoe holds far more packs than any deck could.
+*
+* The draws use the Rng differently from a deck shuffle, so a seeded game
+* dealt from a shoe is a different (equally likely) game than the same
+* seed dealt from a deck.
+*/
+#ifndef SHOE_H
+#define SHOE_H
+
+#include <stdint.h>
+#include "Card.h"
+#include "rng.h"
+
+#define SHOE_KINDS 52 // Distinct cards in a pack
+#define SHOE_MAX_PACKS (UINT64_MAX / SHOE_KINDS) // Most packs a shoe can count
+
+
+/**
+* @struct Shoe
+* @brief Remaining cards of a shoe, by kind. Kind k is suit k / 13, rank
+*        TWO + k % 13.
+*/
+typedef struct {
+	uint64_t count[SHOE_KINDS]; // Cards left of each kind
+	uint64_t tree[SHOE_KINDS + 1]; // Fenwick tree over count, 1-based
+	uint64_t size; // Cards left in total
+} Shoe;
+
+
+/**
+* @brief Empty the shoe.
+*/
+void shoe_clear(Shoe* shoe);
+
+
+/**
+* @brief Fill the shoe with `packs` full packs.
+* @param packs At most SHOE_MAX_PACKS; 0 leaves it empty.
+*/
+void shoe_init(Shoe* shoe, uint64_t packs);
+
+
+/**
+* @brief Cards left in the shoe.
+*/
+static inline uint64_t shoe_size(const Shoe* shoe)
+{
+	return shoe->size;
+}
+
+
+/**
+* @brief Returns 1 if the shoe is empty, 0 otherwise.
+*/
+static inline int shoe_is_empty(const Shoe* shoe)
+{
+	return shoe->size == 0;
+}
+
+
+/**
+* @brief Cards of c's kind left in the shoe.
+*/
+uint64_t shoe_count(const Shoe* shoe, Card c);
+
+
+/**
+* @brief Put n cards of c's kind back in the shoe.
+* @details Exits the program if the shoe would hold more than 2^64 - 1 cards.
+*/
+void shoe_add(Shoe* shoe, Card c, uint64_t n);
+
+
+/**
+* @brief Draw one card, each remaining card equally likely.
+* @return 1 if drawn, 0 if the shoe is empty.
+*/
+int shoe_draw(Shoe* shoe, Rng* rng, Card* out);
+
+
+/**
+* @brief Draw count cards in a row into out.
+* @return 1 if drawn, 0 if the shoe holds fewer than count (nothing drawn).
+*/
+int shoe_deal(Shoe* shoe, Rng* rng, Card* out, int64_t count);
+
+#endif
@@ -0,0 +1,279 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include "perf.h"
+#include "shuffle.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#define CHUNK_SHIFT 20      /* at least 1M cards labelled per stream */
+#define MAX_CHUNKS 1024     /* chunks grow past this so the count table stays small */
+#define BUCKET_SHIFT 18     /* aim for 256K cards a bucket, about one L2 */
+#define MIN_BUCKET_BITS 4   /* at least 16 buckets to spread over threads */
+#define MAX_BUCKET_BITS 12
+
+/* arrays this long or longer take the bucket path */
+static _Atomic int64_t parallelMin = SHUFFLE_PARALLEL_MIN;
+
+/* the three passes; every pass hands out items through one atomic counter */
+enum { PASS_COUNT, PASS_SCATTER, PASS_BUCKETS };
+
+/* one bucket shuffle: shared by every worker, read-only apart from the
+ * counter and each item's own row of table or range of tmp */
+typedef struct {
+    Card* cards;
+    Card* tmp;                 /* cards grouped by bucket */
+    int64_t count;
+    int64_t chunkSize;
+    int64_t chunks;
+    int bits;                  /* log2 of the bucket count */
+    int64_t buckets;
+    Rng* streams;              /* one per chunk, then one per bucket */
+    int64_t* table;            /* [chunk][bucket]: cards, then first slot in tmp */
+    int64_t* start;            /* first slot of each bucket, plus count at the end */
+    int pass;
+    int64_t items;             /* chunks or buckets in this pass */
+    int reversed;              /* position i is cards[count - 1 - i] */
+    _Atomic int64_t next;      /* next item to take */
+} ShuffleJob;
+
+/* labels are cut from 64-bit outputs, bits at a time */
+typedef struct {
+    Rng rng;
+    uint64_t word;
+    int left;
+} LabelStream;
+
+/* Number of online CPUs */
+static int cpu_count(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+/* each card swaps with a uniformly chosen card at or below it; reversed
+ * numbers the positions from the end of the array */
+static void fisher_yates(Card* cards, int64_t count, Rng* rng, int reversed)
+{
+    Card* base = reversed && count > 0 ? cards + count - 1 : cards;
+    int64_t step = reversed ? -1 : 1;
+
+    for (int64_t i = count - 1; i > 0; i--) {
+        int64_t j = (int64_t)rng_bounded64(rng, (uint64_t)i + 1);
+        Card temp = base[step * i];
+        base[step * i] = base[step * j];
+        base[step * j] = temp;
+    }
+}
+
+/* the bucket count is a power of two, so the low bits are an exact uniform pick */
+static inline int64_t next_label(LabelStream* ls, int bits)
+{
+    if (ls->left < bits) {
+        ls->word = rng_next(&ls->rng);
+        ls->left = 64;
+    }
+    int64_t label = (int64_t)(ls->word & ((1ULL << bits) - 1));
+    ls->word >>= bits;
+    ls->left -= bits;
+    return label;
+}
+
+/* pass 1: how many cards of chunk c go to each bucket */
+static void count_chunk(ShuffleJob* job, int64_t c)
+{
+    LabelStream ls = { job->streams[c], 0, 0 };
+    int64_t* row = job->table + c * job->buckets;
+    int64_t end = (c + 1) * job->chunkSize < job->count ? (c + 1) * job->chunkSize : job->count;
+
+    for (int64_t i = c * job->chunkSize; i < end; i++)
+        row[next_label(&ls, job->bits)]++;
+}
+
+/* pass 2: the same labels again, now moving each card to its slot */
+static void scatter_chunk(ShuffleJob* job, int64_t c)
+{
+    LabelStream ls = { job->streams[c], 0, 0 };
+    int64_t* row = job->table + c * job->buckets;
+    int64_t end = (c + 1) * job->chunkSize < job->count ? (c + 1) * job->chunkSize : job->count;
+
+    for (int64_t i = c * job->chunkSize; i < end; i++)
+        job->tmp[row[next_label(&ls, job->bits)]++] = job->cards[job->reversed ? job->count - 1 - i : i];
+}
+
+/* pass 3: shuffle one bucket and copy it home */
+static void shuffle_bucket(ShuffleJob* job, int64_t b)
+{
+    int64_t first = job->start[b];
+    int64_t n = job->start[b + 1] - first;
+    Rng rng = job->streams[job->chunks + b];
+
+    fisher_yates(job->tmp + first, n, &rng, 0);
+    if (job->reversed) {
+        Card* to = job->cards + job->count - 1 - first;
+        for (int64_t i = 0; i < n; i++)
+            to[-i] = job->tmp[first + i];
+    }
+    else
+        memcpy(job->cards + first, job->tmp + first, sizeof(Card) * (size_t)n);
+}
+
+/* take items until the pass runs out */
+static int shuffle_worker(void* arg)
+{
+    ShuffleJob* job = arg;
+    int64_t i;
+
+    while ((i = atomic_fetch_add(&job->next, 1)) < job->items) {
+        if (job->pass == PASS_COUNT)
+            count_chunk(job, i);
+        else if (job->pass == PASS_SCATTER)
+            scatter_chunk(job, i);
+        else
+            shuffle_bucket(job, i);
+    }
+    return 0;
+}
+
+/* run one pass on up to threads threads, the caller being one of them.
+ * Items are taken from a shared counter, so a thread that fails to start
+ * only means the others do its share. */
+static void run_pass(ShuffleJob* job, int pass, int64_t items, int threads, thrd_t* handles)
+{
+    int started = 0;
+
+    job->pass = pass;
+    job->items = items;
+    atomic_store(&job->next, 0);
+
+    if (threads > items)
+        threads = (int)items;
+    for (int t = 1; t < threads; t++) {
+        if (thrd_create(&handles[started], shuffle_worker, job) == thrd_success)
+            started++;
+    }
+    shuffle_worker(job);
+    for (int t = 0; t < started; t++)
+        thrd_join(handles[t], NULL);
+}
+
+/* the scatter-and-shuffle-buckets path */
+static void bucket_shuffle(Card* cards, int64_t count, Rng* rng, int threads, int reversed)
+{
+    if (threads <= 0)
+        threads = cpu_count();
+
+    ShuffleJob job;
+    memset(&job, 0, sizeof(job));
+    job.cards = cards;
+    job.count = count;
+    job.reversed = reversed;
+
+    /* sizes depend only on count, so the result does too */
+    int chunkShift = CHUNK_SHIFT;
+    while ((count >> chunkShift) >= MAX_CHUNKS)
+        chunkShift++;
+    job.chunkSize = (int64_t)1 << chunkShift;
+    job.chunks = (count + job.chunkSize - 1) / job.chunkSize;
+
+    job.bits = MIN_BUCKET_BITS;
+    while (job.bits < MAX_BUCKET_BITS && (count >> BUCKET_SHIFT) > ((int64_t)1 << job.bits))
+        job.bits++;
+    job.buckets = (int64_t)1 << job.bits;
+
+    job.tmp = (uint64_t)count <= SIZE_MAX / sizeof(Card) ? malloc(sizeof(Card) * (size_t)count) : NULL;
+    job.streams = malloc(sizeof(Rng) * (size_t)(job.chunks + job.buckets));
+    job.table = calloc((size_t)(job.chunks * job.buckets), sizeof(int64_t));
+    job.start = malloc(sizeof(int64_t) * (size_t)(job.buckets + 1));
+    thrd_t* handles = malloc(sizeof(thrd_t) * (size_t)threads);
+
+    if (!job.tmp || !job.streams || !job.table || !job.start || !handles) {
+        /* not enough memory for the scatter; the in-place shuffle still works */
+        fisher_yates(cards, count, rng, reversed);
+    }
+    else {
+        /* every stream starts 2^128 outputs after the last */
+        Rng stream;
+        rng_seed(&stream, rng_next(rng));
+        for (int64_t k = 0; k < job.chunks + job.buckets; k++) {
+            job.streams[k] = stream;
+            rng_jump(&stream);
+        }
+
+        run_pass(&job, PASS_COUNT, job.chunks, threads, handles);
+
+        /* bucket-major prefix sum: bucket b holds chunk 0's cards, then chunk 1's, ... */
+        int64_t pos = 0;
+        for (int64_t b = 0; b < job.buckets; b++) {
+            job.start[b] = pos;
+            for (int64_t c = 0; c < job.chunks; c++) {
+                int64_t* cell = &job.table[c * job.buckets + b];
+                int64_t n = *cell;
+                *cell = pos;
+                pos += n;
+            }
+        }
+        job.start[job.buckets] = pos;
+
+        run_pass(&job, PASS_SCATTER, job.chunks, threads, handles);
+        run_pass(&job, PASS_BUCKETS, job.buckets, threads, handles);
+    }
+
+    free(job.tmp);
+    free(job.streams);
+    free(job.table);
+    free(job.start);
+    free(handles);
+}
+
+/* Bucket shuffle for large arrays, Fisher-Yates for the rest */
+static void shuffle(Card* cards, int64_t count, Rng* rng, int threads, int reversed)
+{
+    PERF_TIMER(start);
+    if (count < atomic_load_explicit(&parallelMin, memory_order_relaxed))
+        fisher_yates(cards, count, rng, reversed);
+    else
+        bucket_shuffle(cards, count, rng, threads, reversed);
+    PERF_COUNT(PERF_SHUFFLES, 1);
+    PERF_RECORD(PERF_HIST_SHUFFLE, start);
+}
+
+/* Shuffle on one thread per CPU */
+void card_shuffle(Card* cards, int64_t count, Rng* rng)
+{
+    shuffle(cards, count, rng, 0, 0);
+}
+
+/* Shuffle on the given number of threads */
+void card_shuffle_threads(Card* cards, int64_t count, Rng* rng, int threads)
+{
+    shuffle(cards, count, rng, threads, 0);
+}
+
+/* Shuffle with positions counted from the end of the array */
+void card_shuffle_reversed(Card* cards, int64_t count, Rng* rng)
+{
+    shuffle(cards, count, rng, 0, 1);
+}
+
+/* Move the bucket-shuffle threshold; tests only */
+void shuffle_set_parallel_min(int64_t count)
+{
+    atomic_store_explicit(&parallelMin, count > 0 ? count : SHUFFLE_PARALLEL_MIN, memory_order_relaxed);
+}
+
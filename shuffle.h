@@ -0,0 +1,61 @@
+/**
+* @file shuffle.h
+* @brief Uniform shuffles of card arrays, parallel for very large shoes.
+*
+* Small arrays get a plain Fisher-Yates from the caller's Rng. From
+* SHUFFLE_PARALLEL_MIN cards up, the shuffle is a bucket scatter
+* (Rao-Sandelius): every card is sent to one of B buckets chosen
+* uniformly at random, the buckets are laid out back to back, and each
+* bucket gets its own Fisher-Yates. Bucket labels are independent and
+* uniform and every bucket ends up in a uniformly random order, so every
+* ordering of the whole array is equally likely. Buckets are sized to stay
+* in cache, which is what makes the per-bucket swaps fast.
+*
+* Labels are drawn per fixed-size chunk of input and each bucket is
+* shuffled from its own stream, all split off one rng_next() of the
+* caller's generator. The result therefore depends only on the seed and
+* the card count, never on the number of threads or on scheduling.
+*/
+#ifndef SHUFFLE_H
+#define SHUFFLE_H
+
+#include <stdint.h>
+#include "Card.h"
+#include "rng.h"
+
+#define SHUFFLE_PARALLEL_MIN (1 << 20) // Cards from which the bucket shuffle is used
+
+
+/**
+* @brief Shuffle cards[0..count) uniformly, on one thread per CPU when
+*        count is at least SHUFFLE_PARALLEL_MIN.
+*/
+void card_shuffle(Card* cards, int64_t count, Rng* rng);
+
+
+/**
+* @brief card_shuffle() on a given number of threads.
+* @param threads Worker count; 0 means one per online CPU. Does not change
+*        the result, only how fast it arrives.
+*/
+void card_shuffle_threads(Card* cards, int64_t count, Rng* rng, int threads);
+
+
+/**
+* @brief card_shuffle() of an array kept bottom first, top card last.
+* @details Gives the same order as reversing cards, calling card_shuffle()
+*          and reversing back, without the two extra passes. The array
+*          deck uses it so a seed deals the same game on every backend.
+*/
+void card_shuffle_reversed(Card* cards, int64_t count, Rng* rng);
+
+
+/**
+* @brief Use the bucket shuffle from count cards up instead of from
+*        SHUFFLE_PARALLEL_MIN, so tests can reach it with small arrays.
+* @param count New threshold; 0 or less restores SHUFFLE_PARALLEL_MIN.
+*/
+void shuffle_set_parallel_min(int64_t count);
+
+#endif
+
@@ -0,0 +1,273 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include "game.h"
+#include "gameBatch.h"
+#include "simulator.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+/* one worker: its own range of chunks, game state and statistics.
+ * range packs [begin, end) chunk indices as (begin << 32) | end so the
+ * owner and thieves agree with a single compare-and-swap. It is only
+ * written once per chunk; game and stats are written every game and are
+ * kept a cache line away from the next worker's fields by pad. */
+typedef struct SimWorker {
+    _Atomic uint64_t range;
+    struct SimWorker* all;     /* every worker, for stealing */
+    int id;
+    int count;                 /* number of workers */
+    const SimConfig* cfg;
+    int chunk;                 /* games per chunk */
+    Game game;
+    GameBatch batch;           /* used instead of game when cfg->lanes > 0 */
+    BatchResult* results;      /* room for one step's finished games */
+    SimStats stats;
+    char pad[64];
+} SimWorker;
+
+#define RANGE(b, e) (((uint64_t)(b) << 32) | (uint64_t)(e))
+#define RANGE_BEGIN(r) ((uint32_t)((r) >> 32))
+#define RANGE_END(r) ((uint32_t)(r))
+
+/* Number of online CPUs */
+int sim_cpu_count(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+/* Zero a statistics block */
+void sim_stats_init(SimStats* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+/* Add src into dst; sums only, so merge order does not matter */
+void sim_stats_merge(SimStats* dst, const SimStats* src)
+{
+    dst->games += src->games;
+    for (int i = 0; i < 3; i++)
+        dst->wins[i] += src->wins[i];
+    dst->turns += src->turns;
+    dst->refills += src->refills;
+    if (src->max_refills > dst->max_refills)
+        dst->max_refills = src->max_refills;
+    for (int i = 0; i < SIM_TURN_BUCKETS; i++)
+        dst->turn_hist[i] += src->turn_hist[i];
+}
+
+/* Walk the histogram until q of the games are covered */
+int sim_stats_turn_quantile(const SimStats* stats, double q)
+{
+    uint64_t target = (uint64_t)(q * (double)stats->games);
+    uint64_t seen = 0;
+
+    for (int t = 0; t < SIM_TURN_BUCKETS; t++) {
+        seen += stats->turn_hist[t];
+        if (seen >= target && seen > 0)
+            return t;
+    }
+    return SIM_TURN_BUCKETS - 1;
+}
+
+/* take the next chunk from the front of our own range */
+static int claim_own(SimWorker* w, uint32_t* chunk)
+{
+    uint64_t r = atomic_load(&w->range);
+
+    while (RANGE_BEGIN(r) < RANGE_END(r)) {
+        if (atomic_compare_exchange_weak(&w->range, &r, RANGE(RANGE_BEGIN(r) + 1, RANGE_END(r)))) {
+            *chunk = RANGE_BEGIN(r);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* move the back half of some other worker's range into ours */
+static int steal(SimWorker* w)
+{
+    for (int k = 1; k < w->count; k++) {
+        SimWorker* victim = &w->all[(w->id + k) % w->count];
+        uint64_t r = atomic_load(&victim->range);
+
+        while (RANGE_BEGIN(r) < RANGE_END(r)) {
+            uint32_t take = (RANGE_END(r) - RANGE_BEGIN(r) + 1) / 2;
+            uint32_t split = RANGE_END(r) - take;
+            if (atomic_compare_exchange_weak(&victim->range, &r, RANGE(RANGE_BEGIN(r), split))) {
+                atomic_store(&w->range, RANGE(split, split + take));
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* add one finished game to a worker's totals */
+static void record_game(SimStats* stats, int winner, int turns, int refills)
+{
+    stats->games++;
+    stats->wins[winner]++;
+    stats->turns += (uint64_t)turns;
+    stats->refills += (uint64_t)refills;
+    if ((uint64_t)refills > stats->max_refills)
+        stats->max_refills = (uint64_t)refills;
+    stats->turn_hist[turns < SIM_TURN_BUCKETS ? turns : SIM_TURN_BUCKETS - 1]++;
+}
+
+/* Murmur3's 64-bit finalizer: every input bit affects every output bit */
+static uint64_t mix64(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+/* a chunk's seed: (seed, chunk) hashed, so that no two chunks start
+ * rng_seed()'s splitmix64 sequence at related points */
+static uint64_t chunk_seed(uint64_t seed, uint32_t chunk)
+{
+    return mix64(mix64(seed) + chunk);
+}
+
+/* play every game of one chunk with that chunk's own generator */
+static void run_chunk(SimWorker* w, uint32_t chunk)
+{
+    uint64_t first = (uint64_t)chunk * (uint64_t)w->chunk;
+    uint64_t count = w->cfg->games - first;
+    uint64_t seed = chunk_seed(w->cfg->seed, chunk);
+
+    if (count > (uint64_t)w->chunk)
+        count = (uint64_t)w->chunk;
+
+    if (w->cfg->lanes > 0) {
+        /* the chunk's games all at once, lanes at a time */
+        rng_seed(&w->batch.rng, seed);
+        batch_start(&w->batch, count);
+        while (batch_running(&w->batch)) {
+            int done = batch_step(&w->batch, w->results);
+            for (int i = 0; i < done; i++)
+                record_game(&w->stats, w->results[i].winner, w->results[i].turns, w->results[i].refills);
+        }
+        return;
+    }
+
+    rng_seed(&w->game.rng, seed);
+    for (uint64_t i = 0; i < count; i++) {
+        int winner = play_game(&w->game, w->cfg->packs);
+        record_game(&w->stats, winner, w->game.turns, w->game.refills);
+    }
+}
+
+/* worker loop: drain our range, then steal until nothing is left */
+static int worker_main(void* arg)
+{
+    SimWorker* w = arg;
+    uint32_t chunk;
+
+    do {
+        while (claim_own(w, &chunk))
+            run_chunk(w, chunk);
+    } while (steal(w));
+    return 0;
+}
+
+/* release every worker's batch; safe on workers that never got one */
+static void free_batches(SimWorker* workers, int threads)
+{
+    for (int i = 0; i < threads; i++) {
+        batch_free(&workers[i].batch);
+        free(workers[i].results);
+    }
+}
+
+/* Run the simulation */
+int sim_run(const SimConfig* cfg, SimStats* out)
+{
+    int threads = cfg->threads > 0 ? cfg->threads : sim_cpu_count();
+    int chunk = cfg->chunk > 0 ? cfg->chunk
+        : cfg->lanes > 0 ? cfg->lanes * SIM_LANE_GAMES : SIM_CHUNK_GAMES;
+    uint64_t chunks = (cfg->games + (uint64_t)chunk - 1) / (uint64_t)chunk;
+
+    sim_stats_init(out);
+    if (chunks > UINT32_MAX)
+        return -1;
+
+    SimWorker* workers = malloc(sizeof(SimWorker) * (size_t)threads);
+    thrd_t* handles = malloc(sizeof(thrd_t) * (size_t)threads);
+    if (!workers || !handles) {
+        free(workers);
+        free(handles);
+        return -1;
+    }
+
+    /* contiguous equal shares up front; stealing evens out the rest */
+    for (int i = 0; i < threads; i++) {
+        SimWorker* w = &workers[i];
+        memset(w, 0, sizeof(*w));
+        atomic_init(&w->range, RANGE(chunks * (uint64_t)i / (uint64_t)threads,
+            chunks * (uint64_t)(i + 1) / (uint64_t)threads));
+        w->all = workers;
+        w->id = i;
+        w->count = threads;
+        w->cfg = cfg;
+        w->chunk = chunk;
+        w->game.verbosity = VERBOSITY_QUIET;
+        w->game.interactive = 0;
+        w->game.use_shoe = cfg->use_shoe;
+    }
+
+    if (cfg->lanes > 0) {
+        int ok = 1;
+        for (int i = 0; i < threads; i++) {
+            SimWorker* w = &workers[i];
+            w->results = malloc(sizeof(BatchResult) * (size_t)cfg->lanes);
+            if (!w->results || batch_init(&w->batch, cfg->lanes, cfg->packs) != 0)
+                ok = 0;
+        }
+        if (!ok) {
+            free_batches(workers, threads);
+            free(workers);
+            free(handles);
+            return -1;
+        }
+    }
+
+    /* worker 0 runs on the calling thread; if a thread fails to start,
+     * the running workers steal its chunks, so every game is still played */
+    int started = 1;
+    for (; started < threads; started++) {
+        if (thrd_create(&handles[started], worker_main, &workers[started]) != thrd_success)
+            break;
+    }
+    worker_main(&workers[0]);
+    for (int i = 1; i < started; i++)
+        thrd_join(handles[i], NULL);
+
+    for (int i = 0; i < threads; i++)
+        sim_stats_merge(out, &workers[i].stats);
+
+    free_batches(workers, threads);
+    free(workers);
+    free(handles);
+    return 0;
+}
@@ -0,0 +1,87 @@
+/**
+* @file simulator.h
+* @brief Multi-threaded Monte Carlo runner for game.h.
+*
+* Games are grouped into fixed-size chunks. Chunk k always plays with an
+* Rng seeded from a hash of (seed, k), so the merged statistics depend only
+* on the seed, the game count and the chunk size, never on scheduling or
+* thread count. Each worker owns its Game (decks, hands, Rng) and its
+* SimStats; workers only touch shared memory when they claim the next
+* chunk, and steal half of another worker's remaining chunks when their
+* own run out.
+*
+* With lanes set, a worker plays each chunk through a GameBatch instead of
+* one Game. Batched games always draw like a Shoe, so use_shoe is moot, and
+* the results then also depend on the lane count.
+*/
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <stdint.h>
+
+#define SIM_TURN_BUCKETS 512 // Turn histogram size; longer games land in the last bucket
+#define SIM_CHUNK_GAMES 256 // Default games per chunk
+#define SIM_LANE_GAMES 64 // Default games per lane in a chunk when batching; lanes idle while a chunk's last games finish
+
+
+/**
+* @struct SimConfig
+* @brief What to simulate and with how many threads.
+*/
+typedef struct {
+	int64_t packs; // Packs per game
+	int use_shoe; // 1 to draw from a Shoe instead of a shuffled deck
+	uint64_t games; // Total games to play
+	uint64_t seed; // Base seed; same seed gives the same results
+	int threads; // Worker count; 0 means one per online CPU
+	int chunk; // Games per chunk; 0 means SIM_CHUNK_GAMES, or lanes * SIM_LANE_GAMES with lanes set
+	int lanes; // Games each worker steps together (gameBatch.h); 0 plays them one at a time
+} SimConfig;
+
+
+/**
+* @struct SimStats
+* @brief Totals over a batch of games. Merge with sim_stats_merge().
+*/
+typedef struct {
+	uint64_t games; // Games played
+	uint64_t wins[3]; // Games won by seat 1 and 2; index 0 counts stalemates
+	uint64_t turns; // Sum of turns over all games
+	uint64_t refills; // Sum of hidden-deck refills over all games
+	uint64_t max_refills; // Most refills seen in one game
+	uint64_t turn_hist[SIM_TURN_BUCKETS]; // Games by turn count
+} SimStats;
+
+
+/**
+* @brief Number of online CPUs, at least 1.
+*/
+int sim_cpu_count(void);
+
+
+/**
+* @brief Zero a statistics block.
+*/
+void sim_stats_init(SimStats* stats);
+
+
+/**
+* @brief Add the totals of src into dst.
+*/
+void sim_stats_merge(SimStats* dst, const SimStats* src);
+
+
+/**
+* @brief Smallest turn count t such that at least q (0..1) of games took <= t turns.
+*/
+int sim_stats_turn_quantile(const SimStats* stats, double q);
+
+
+/**
+* @brief Run the simulation and store merged statistics in out.
+* @return 0 on success, -1 if out of memory, the game count needs more than 2^32 chunks,
+*         or lanes is set and packs is over BATCH_MAX_PACKS.
+*/
+int sim_run(const SimConfig* cfg, SimStats* out);
+
+#endif
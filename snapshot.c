@@ -0,0 +1,514 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "snapshot.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define HEADER_SIZE 40
+#define ENTRY_SIZE 24
+#define STATE_FIELDS 11
+
+static const char magic[8] = { 'C', 'A', 'R', 'D', 'S', 'N', 'A', 'P' };
+
+#define FNV_OFFSET 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x100000001B3ULL
+
+/* ---------------- encoding ---------------- */
+
+static void put_u32(unsigned char* p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static void put_u64(unsigned char* p, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+        p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static uint32_t get_u32(const unsigned char* p)
+{
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; i--)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+static uint64_t get_u64(const unsigned char* p)
+{
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+static uint64_t fnv1a(uint64_t h, const unsigned char* p, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        h ^= p[i];
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+/* ---------------- writer ---------------- */
+
+static int writer_put(SnapshotWriter* w, const void* data, size_t bytes)
+{
+    if (w->failed)
+        return SNAPSHOT_EIO;
+    if (bytes && fwrite(data, 1, bytes, w->file) != bytes) {
+        w->failed = 1;
+        return SNAPSHOT_EIO;
+    }
+    w->checksum = fnv1a(w->checksum, data, bytes);
+    w->offset += bytes;
+    return SNAPSHOT_OK;
+}
+
+/* Create the file and reserve the header */
+int snapshot_writer_open(SnapshotWriter* w, const char* path, uint32_t kind)
+{
+    unsigned char header[HEADER_SIZE] = { 0 };
+
+    memset(w, 0, sizeof(*w));
+    w->kind = kind;
+    w->checksum = FNV_OFFSET;
+    w->file = fopen(path, "wb");
+    if (!w->file)
+        return SNAPSHOT_EIO;
+
+    /* zeros for now; close() writes the real header */
+    if (fwrite(header, 1, HEADER_SIZE, w->file) != HEADER_SIZE) {
+        fclose(w->file);
+        w->file = NULL;
+        return SNAPSHOT_EIO;
+    }
+    w->offset = HEADER_SIZE;
+    return SNAPSHOT_OK;
+}
+
+/* Start a section */
+int snapshot_writer_begin(SnapshotWriter* w, uint32_t type)
+{
+    if (w->failed || w->sectionType != 0 || type == 0)
+        return SNAPSHOT_EFORMAT;
+    w->sectionType = type;
+    w->sectionStart = w->offset;
+    return SNAPSHOT_OK;
+}
+
+/* Stream bytes into the open section */
+int snapshot_writer_append(SnapshotWriter* w, const void* data, size_t bytes)
+{
+    if (w->sectionType == 0)
+        return SNAPSHOT_EFORMAT;
+    return writer_put(w, data, bytes);
+}
+
+/* Record the finished section in the table */
+int snapshot_writer_end(SnapshotWriter* w)
+{
+    if (w->failed)
+        return SNAPSHOT_EIO;
+    if (w->sectionType == 0)
+        return SNAPSHOT_EFORMAT;
+
+    if (w->count == w->capacity) {
+        uint32_t cap = w->capacity ? w->capacity * 2 : 8;
+        unsigned char* table = realloc(w->table, (size_t)cap * ENTRY_SIZE);
+        if (!table) {
+            fprintf(stderr, "Memory allocation failed in snapshot_writer_end()\n");
+            exit(EXIT_FAILURE);
+        }
+        w->table = table;
+        w->capacity = cap;
+    }
+
+    unsigned char* e = w->table + (size_t)w->count * ENTRY_SIZE;
+    put_u32(e, w->sectionType);
+    put_u32(e + 4, 0);
+    put_u64(e + 8, w->sectionStart);
+    put_u64(e + 16, w->offset - w->sectionStart);
+    w->count++;
+    w->sectionType = 0;
+    return SNAPSHOT_OK;
+}
+
+/* Append the table, then go back and fill in the header */
+int snapshot_writer_close(SnapshotWriter* w)
+{
+    int rc = SNAPSHOT_OK;
+    unsigned char header[HEADER_SIZE] = { 0 };
+    uint64_t tableOffset = w->offset;
+
+    if (!w->file)
+        return SNAPSHOT_EIO;
+
+    if (w->sectionType != 0)
+        rc = SNAPSHOT_EFORMAT;      /* section left open */
+    else
+        rc = writer_put(w, w->table, (size_t)w->count * ENTRY_SIZE);
+
+    if (rc == SNAPSHOT_OK) {
+        memcpy(header, magic, sizeof(magic));
+        put_u32(header + 8, SNAPSHOT_VERSION);
+        put_u32(header + 12, w->kind);
+        put_u64(header + 16, tableOffset);
+        put_u32(header + 24, w->count);
+        put_u32(header + 28, 0);
+        put_u64(header + 32, w->checksum);
+        if (fseek(w->file, 0, SEEK_SET) != 0 || fwrite(header, 1, HEADER_SIZE, w->file) != HEADER_SIZE)
+            rc = SNAPSHOT_EIO;
+    }
+
+    if (fclose(w->file) != 0 && rc == SNAPSHOT_OK)
+        rc = SNAPSHOT_EIO;
+    free(w->table);
+    w->file = NULL;
+    w->table = NULL;
+    return rc;
+}
+
+/* write one section holding the given cards */
+static int write_cards(SnapshotWriter* w, uint32_t type, const Card* cards, int64_t count)
+{
+    int rc = snapshot_writer_begin(w, type);
+    if (rc == SNAPSHOT_OK && count > 0)
+        rc = snapshot_writer_append(w, cards, sizeof(Card) * (size_t)count);
+    if (rc == SNAPSHOT_OK)
+        rc = snapshot_writer_end(w);
+    return rc;
+}
+
+/* a deck section, top card first */
+static int write_deck(SnapshotWriter* w, uint32_t type, const CardDeck* deck)
+{
+    Card* cards = carddeck_to_array(deck);
+    int rc;
+
+    if (!cards && !carddeck_is_empty(deck)) {
+        fprintf(stderr, "Memory allocation failed in snapshot_save_deck()\n");
+        exit(EXIT_FAILURE);
+    }
+    rc = write_cards(w, type, cards, carddeck_size(deck));
+    free(cards);
+    return rc;
+}
+
+/* the shoe's counts, kind order */
+static int write_shoe(SnapshotWriter* w, const Shoe* shoe)
+{
+    unsigned char counts[SHOE_KINDS * 8];
+    for (int k = 0; k < SHOE_KINDS; k++)
+        put_u64(counts + 8 * k, shoe->count[k]);
+
+    int rc = snapshot_writer_begin(w, SNAP_SHOE);
+    if (rc == SNAPSHOT_OK)
+        rc = snapshot_writer_append(w, counts, sizeof(counts));
+    if (rc == SNAPSHOT_OK)
+        rc = snapshot_writer_end(w);
+    return rc;
+}
+
+/* Save a deck */
+int snapshot_save_deck(const char* path, const CardDeck* deck)
+{
+    SnapshotWriter w;
+    int rc = snapshot_writer_open(&w, path, SNAPSHOT_KIND_DECK);
+    if (rc != SNAPSHOT_OK)
+        return rc;
+
+    rc = write_deck(&w, SNAP_CARDS, deck);
+    int closed = snapshot_writer_close(&w);
+    return rc != SNAPSHOT_OK ? rc : closed;
+}
+
+/* Save a whole game */
+int snapshot_save_game(const char* path, const Game* g)
+{
+    SnapshotWriter w;
+    unsigned char state[STATE_FIELDS * 8];
+    int rc = snapshot_writer_open(&w, path, SNAPSHOT_KIND_GAME);
+    if (rc != SNAPSHOT_OK)
+        return rc;
+
+    for (int i = 0; i < 4; i++)
+        put_u64(state + 8 * i, g->rng.s[i]);
+    put_u64(state + 32, (uint64_t)g->packs);
+    put_u64(state + 40, (uint64_t)g->turn);
+    put_u64(state + 48, (uint64_t)g->passes);
+    put_u64(state + 56, (uint64_t)g->winner);
+    put_u64(state + 64, (uint64_t)g->over);
+    put_u64(state + 72, (uint64_t)g->turns);
+    put_u64(state + 80, (uint64_t)g->refills);
+
+    rc = snapshot_writer_begin(&w, SNAP_STATE);
+    if (rc == SNAPSHOT_OK)
+        rc = snapshot_writer_append(&w, state, sizeof(state));
+    if (rc == SNAPSHOT_OK)
+        rc = snapshot_writer_end(&w);
+    if (rc == SNAPSHOT_OK)
+        rc = write_deck(&w, SNAP_HIDDEN, &g->hidden);
+    if (rc == SNAPSHOT_OK)
+        rc = write_deck(&w, SNAP_PLAYED, &g->played);
+    for (int p = 0; p < 2 && rc == SNAPSHOT_OK; p++)
+        rc = write_cards(&w, SNAP_HAND, g->players[p].hand.cards, g->players[p].hand.size);
+    if (rc == SNAPSHOT_OK && g->use_shoe)
+        rc = write_shoe(&w, &g->shoe);
+
+    int closed = snapshot_writer_close(&w);
+    return rc != SNAPSHOT_OK ? rc : closed;
+}
+
+/* ---------------- reader ---------------- */
+
+/* map the whole file read-only */
+static int map_file(Snapshot* snap, const char* path)
+{
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER size;
+    if (file == INVALID_HANDLE_VALUE)
+        return SNAPSHOT_EIO;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return SNAPSHOT_EIO;
+    }
+    if (size.QuadPart < HEADER_SIZE) {
+        CloseHandle(file);
+        return SNAPSHOT_EFORMAT;    /* too short to be a snapshot */
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);      /* the mapping keeps the file open */
+    if (!mapping)
+        return SNAPSHOT_EIO;
+    const void* base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!base) {
+        CloseHandle(mapping);
+        return SNAPSHOT_EIO;
+    }
+    snap->base = base;
+    snap->size = (uint64_t)size.QuadPart;
+    snap->handle = mapping;
+#else
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return SNAPSHOT_EIO;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return SNAPSHOT_EIO;
+    }
+    if (st.st_size < HEADER_SIZE) {
+        close(fd);
+        return SNAPSHOT_EFORMAT;    /* too short to be a snapshot */
+    }
+    void* base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);              /* the mapping keeps the file open */
+    if (base == MAP_FAILED)
+        return SNAPSHOT_EIO;
+    snap->base = base;
+    snap->size = (uint64_t)st.st_size;
+    snap->handle = NULL;
+#endif
+    return SNAPSHOT_OK;
+}
+
+/* Map and validate */
+int snapshot_open(Snapshot* snap, const char* path, int verify)
+{
+    memset(snap, 0, sizeof(*snap));
+    int rc = map_file(snap, path);
+    if (rc != SNAPSHOT_OK)
+        return rc;
+
+    const unsigned char* h = snap->base;
+    uint64_t tableOffset = get_u64(h + 16);
+    uint32_t sections = get_u32(h + 24);
+
+    rc = SNAPSHOT_EFORMAT;
+    if (memcmp(h, magic, sizeof(magic)) != 0 || get_u32(h + 8) != SNAPSHOT_VERSION)
+        goto fail;
+    if (tableOffset < HEADER_SIZE || tableOffset > snap->size
+        || (snap->size - tableOffset) / ENTRY_SIZE != sections || (snap->size - tableOffset) % ENTRY_SIZE != 0)
+        goto fail;
+
+    snap->kind = get_u32(h + 12);
+    snap->sections = sections;
+    snap->table = snap->base + tableOffset;
+
+    /* every section must lie between the header and the table */
+    for (uint32_t i = 0; i < sections; i++) {
+        const unsigned char* e = snap->table + (size_t)i * ENTRY_SIZE;
+        uint64_t offset = get_u64(e + 8);
+        uint64_t bytes = get_u64(e + 16);
+        if (offset < HEADER_SIZE || offset > tableOffset || bytes > tableOffset - offset)
+            goto fail;
+    }
+
+    if (verify && fnv1a(FNV_OFFSET, snap->base + HEADER_SIZE, (size_t)(snap->size - HEADER_SIZE)) != get_u64(h + 32)) {
+        rc = SNAPSHOT_ECHECKSUM;
+        goto fail;
+    }
+    return SNAPSHOT_OK;
+
+fail:
+    snapshot_close(snap);
+    return rc;
+}
+
+/* Unmap */
+void snapshot_close(Snapshot* snap)
+{
+    if (snap->base) {
+#if defined(_WIN32)
+        UnmapViewOfFile(snap->base);
+        CloseHandle(snap->handle);
+#else
+        munmap((void*)snap->base, (size_t)snap->size);
+#endif
+    }
+    memset(snap, 0, sizeof(*snap));
+}
+
+/* Look a section up in the table */
+int snapshot_section(const Snapshot* snap, uint32_t type, int nth, const unsigned char** data, uint64_t* bytes)
+{
+    for (uint32_t i = 0; i < snap->sections; i++) {
+        const unsigned char* e = snap->table + (size_t)i * ENTRY_SIZE;
+        if (get_u32(e) != type || nth-- > 0)
+            continue;
+        *data = snap->base + get_u64(e + 8);
+        *bytes = get_u64(e + 16);
+        return SNAPSHOT_OK;
+    }
+    return SNAPSHOT_EFORMAT;
+}
+
+/* a card section, every byte checked to be a card */
+static int card_section(const Snapshot* snap, uint32_t type, int nth, const Card** cards, int64_t* count)
+{
+    const unsigned char* data;
+    uint64_t bytes;
+    int rc = snapshot_section(snap, type, nth, &data, &bytes);
+    if (rc != SNAPSHOT_OK)
+        return rc;
+    if (bytes > INT64_MAX)
+        return SNAPSHOT_EFORMAT;
+    for (uint64_t i = 0; i < bytes; i++) {
+        Card c = { data[i] };
+        if ((c.bits & ~(CARD_SUIT_MASK | CARD_RANK_MASK)) || card_rank(c) < TWO || card_rank(c) > ACE)
+            return SNAPSHOT_EFORMAT;    /* not a card */
+    }
+    *cards = (const Card*)data;
+    *count = (int64_t)bytes;
+    return SNAPSHOT_OK;
+}
+
+/* fill an empty deck from top-first cards: push from the bottom up */
+static void fill_deck(CardDeck* deck, const Card* cards, int64_t count)
+{
+    carddeck_init(deck);
+    for (int64_t i = count - 1; i >= 0; i--)
+        carddeck_push_top(deck, cards[i]);
+}
+
+/* Copy a deck snapshot into a deck */
+int snapshot_load_deck(const Snapshot* snap, CardDeck* deck)
+{
+    const Card* cards;
+    int64_t count;
+
+    if (snap->kind != SNAPSHOT_KIND_DECK)
+        return SNAPSHOT_EFORMAT;
+    int rc = card_section(snap, SNAP_CARDS, 0, &cards, &count);
+    if (rc != SNAPSHOT_OK)
+        return rc;
+    fill_deck(deck, cards, count);
+    return SNAPSHOT_OK;
+}
+
+/* Rebuild a game */
+int snapshot_load_game(const Snapshot* snap, Game* g)
+{
+    const unsigned char* state;
+    uint64_t stateBytes;
+    const Card* hidden, * played, * hands[2];
+    const unsigned char* shoe;
+    uint64_t shoeBytes;
+    int64_t hiddenCount, playedCount, handCounts[2];
+
+    if (snap->kind != SNAPSHOT_KIND_GAME)
+        return SNAPSHOT_EFORMAT;
+    if (snapshot_section(snap, SNAP_STATE, 0, &state, &stateBytes) != SNAPSHOT_OK || stateBytes != STATE_FIELDS * 8)
+        return SNAPSHOT_EFORMAT;
+    if (card_section(snap, SNAP_HIDDEN, 0, &hidden, &hiddenCount) != SNAPSHOT_OK
+        || card_section(snap, SNAP_PLAYED, 0, &played, &playedCount) != SNAPSHOT_OK
+        || card_section(snap, SNAP_HAND, 0, &hands[0], &handCounts[0]) != SNAPSHOT_OK
+        || card_section(snap, SNAP_HAND, 1, &hands[1], &handCounts[1]) != SNAPSHOT_OK)
+        return SNAPSHOT_EFORMAT;
+
+    uint64_t packs = get_u64(state + 32);
+    uint64_t turn = get_u64(state + 40);
+    uint64_t passes = get_u64(state + 48);
+    uint64_t winner = get_u64(state + 56);
+    uint64_t over = get_u64(state + 64);
+    if (packs < 1 || packs > INT64_MAX || (turn != 1 && turn != 2))
+        return SNAPSHOT_EFORMAT;
+    if (over > 1 || winner > 2 || passes > 2 || get_u64(state + 72) > INT_MAX || get_u64(state + 80) > INT_MAX)
+        return SNAPSHOT_EFORMAT;
+    /* a running game has no winner, a top card and at most one pass */
+    if (!over && (winner != 0 || passes > 1 || playedCount == 0))
+        return SNAPSHOT_EFORMAT;
+
+    /* the shoe section is only there for games drawing from a shoe */
+    g->use_shoe = snapshot_section(snap, SNAP_SHOE, 0, &shoe, &shoeBytes) == SNAPSHOT_OK;
+    if (g->use_shoe) {
+        uint64_t total = 0;
+        if (shoeBytes != SHOE_KINDS * 8)
+            return SNAPSHOT_EFORMAT;
+        for (int k = 0; k < SHOE_KINDS; k++) {
+            uint64_t n = get_u64(shoe + 8 * k);
+            if (n > UINT64_MAX - total)
+                return SNAPSHOT_EFORMAT;
+            total += n;
+        }
+    }
+
+    for (int i = 0; i < 4; i++)
+        g->rng.s[i] = get_u64(state + 8 * i);
+    g->packs = (int64_t)packs;
+    g->turn = (int)turn;
+    g->passes = (int)passes;
+    g->winner = (int)winner;
+    g->over = (int)over;
+    g->turns = (int)get_u64(state + 72);
+    g->refills = (int)get_u64(state + 80);
+
+    fill_deck(&g->hidden, hidden, hiddenCount);
+    fill_deck(&g->played, played, playedCount);
+    shoe_clear(&g->shoe);
+    for (int k = 0; g->use_shoe && k < SHOE_KINDS; k++)
+        shoe_add(&g->shoe, card_create((Suit)(k / 13), (Rank)(TWO + k % 13)), get_u64(shoe + 8 * k));
+    for (int p = 0; p < 2; p++) {
+        CardView view = { hands[p], handCounts[p] };
+        player_init(&g->players[p], g->packs);
+        player_take_all(&g->players[p], view);
+    }
+    game_rehash(g);
+    return SNAPSHOT_OK;
+}
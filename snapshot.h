@@ -0,0 +1,166 @@
+/**
+* @file snapshot.h
+* @brief Versioned binary snapshots of decks and game state, loaded by mmap.
+*
+* File layout (all integers little-endian):
+*   header   40 bytes: magic "CARDSNAP", version, kind, table offset,
+*            section count, reserved, FNV-1a 64 checksum of every byte
+*            after the header
+*   payload  sections back to back; card sections are raw packed Card
+*            bytes, top card first
+*   table    one 24-byte entry per section: type, reserved, offset, length
+*
+* The table comes last so a writer can stream sections of any length
+* without knowing their sizes up front. A reader maps the file and hands
+* out pointers straight into the mapping, so a deck of any size is usable
+* without parsing or copying. Checksum verification is optional because
+* it has to read every byte.
+*/
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "Card.h"
+#include "game.h"
+
+#define SNAPSHOT_VERSION 1
+
+/* what a snapshot holds */
+#define SNAPSHOT_KIND_DECK 1 // One SNAP_CARDS section
+#define SNAPSHOT_KIND_GAME 2 // A whole Game: state, hidden, played, one hand per player
+
+/* section types */
+#define SNAP_CARDS 1 // A deck's cards, top first
+#define SNAP_HIDDEN 2 // Game hidden deck, top first
+#define SNAP_PLAYED 3 // Game played pile, top first
+#define SNAP_HAND 4 // One player's hand, lowest card first; one per seat, in seat order
+#define SNAP_STATE 5 // Game counters and RNG state
+#define SNAP_SHOE 6 // Game shoe: 52 u64 counts in kind order; only in games using a shoe
+
+/* results; every function returns SNAPSHOT_OK or one of the negative codes */
+#define SNAPSHOT_OK 0
+#define SNAPSHOT_EIO (-1) // File could not be opened, mapped, read or written
+#define SNAPSHOT_EFORMAT (-2) // Not a snapshot, wrong version or kind, or damaged layout
+#define SNAPSHOT_ECHECKSUM (-3) // Layout fine but the contents do not match the checksum
+
+
+/**
+* @struct SnapshotWriter
+* @brief Streams sections to a file. Open, then begin/append/end each
+*        section, then close.
+*/
+typedef struct {
+	FILE* file;
+	uint32_t kind;
+	uint64_t offset; // Bytes written so far
+	uint64_t checksum; // Running FNV-1a of everything after the header
+	uint64_t sectionStart; // Offset of the open section
+	uint32_t sectionType; // Type of the open section, 0 if none
+	uint32_t count; // Sections finished
+	uint32_t capacity; // Entries allocated in table
+	unsigned char* table; // Finished entries, already encoded
+	int failed; // Set after any write error
+} SnapshotWriter;
+
+
+/**
+* @struct Snapshot
+* @brief A snapshot file mapped read-only into memory.
+*/
+typedef struct {
+	const unsigned char* base; // Start of the mapping
+	uint64_t size; // File size in bytes
+	uint32_t kind; // SNAPSHOT_KIND_*
+	uint32_t sections; // Entries in the table
+	const unsigned char* table; // First table entry
+	void* handle; // Platform mapping handle (Windows only)
+} Snapshot;
+
+
+/**
+* @brief Create (truncate) a snapshot file and write a placeholder header.
+*/
+int snapshot_writer_open(SnapshotWriter* w, const char* path, uint32_t kind);
+
+
+/**
+* @brief Start a new section of the given type.
+*/
+int snapshot_writer_begin(SnapshotWriter* w, uint32_t type);
+
+
+/**
+* @brief Append raw bytes to the open section. May be called any number of
+*        times, so a section can be far larger than memory.
+*/
+int snapshot_writer_append(SnapshotWriter* w, const void* data, size_t bytes);
+
+
+/**
+* @brief Finish the open section.
+*/
+int snapshot_writer_end(SnapshotWriter* w);
+
+
+/**
+* @brief Write the section table, patch the header and close the file.
+* @details Always closes and frees the writer, even after an error.
+*/
+int snapshot_writer_close(SnapshotWriter* w);
+
+
+/**
+* @brief Write a deck's cards, top first, as a SNAPSHOT_KIND_DECK file.
+*/
+int snapshot_save_deck(const char* path, const CardDeck* deck);
+
+
+/**
+* @brief Write everything needed to resume a game with game_step().
+*/
+int snapshot_save_game(const char* path, const Game* g);
+
+
+/**
+* @brief Map a snapshot file and check its header and table.
+* @param verify 1 to also check the checksum (reads the whole file).
+*/
+int snapshot_open(Snapshot* snap, const char* path, int verify);
+
+
+/**
+* @brief Unmap the file. Pointers from snapshot_section() become invalid.
+*/
+void snapshot_close(Snapshot* snap);
+
+
+/**
+* @brief Find the nth (0-based) section of a type.
+* @param data Set to the section's first byte inside the mapping.
+* @param bytes Set to its length.
+* @return SNAPSHOT_OK, or SNAPSHOT_EFORMAT if there is no such section.
+*/
+int snapshot_section(const Snapshot* snap, uint32_t type, int nth, const unsigned char** data, uint64_t* bytes);
+
+
+/**
+* @brief Build a deck from a SNAPSHOT_KIND_DECK snapshot.
+* @details The deck is mutable, so this copies; read the section directly
+*          with snapshot_section() for zero-copy access.
+*/
+int snapshot_load_deck(const Snapshot* snap, CardDeck* deck);
+
+
+/**
+* @brief Restore a game saved by snapshot_save_game().
+* @details Sets every field except verbosity and interactive, which stay
+*          as the caller set them. Continue with game_step() and release
+*          with game_free(). A state no game can reach, such as a running
+*          game with no top card, a winner or two passes, is
+*          SNAPSHOT_EFORMAT.
+*/
+int snapshot_load_game(const Snapshot* snap, Game* g);
+
+#endif
@@ -0,0 +1,272 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "strategy.h"
+#include "transTable.h"
+
+#define WIN_SCORE 1000.0      /* beats any hand-size difference */
+#define ROLLOUT_TURNS 200     /* playouts longer than this count as a draw */
+#define UCT_C 1.4
+#define TT_MIN_DEPTH 2        /* shallower subtrees cost less than a probe */
+#define TT_DEPTH_KEY 0x9E3779B97F4A7C15ULL
+
+/* ---------------- greedy and random ---------------- */
+
+/* lowest playable card, as game_choose_move() picks */
+static int choose_greedy(const Strategy* self, const GameState* s, Rng* rng)
+{
+    int moves[GAMESTATE_MAX_MOVES];
+    (void)self;
+    (void)rng;
+    gamestate_legal_moves(s, moves);
+    return moves[0];
+}
+
+static int choose_random(const Strategy* self, const GameState* s, Rng* rng)
+{
+    int moves[GAMESTATE_MAX_MOVES];
+    (void)self;
+    int n = gamestate_legal_moves(s, moves);
+    return moves[rng_bounded(rng, (uint32_t)n)];
+}
+
+/* ---------------- expectimax ---------------- */
+
+/* value of s for seat me: wins and losses, else how many fewer cards me holds */
+static double evaluate(const GameState* s, int me)
+{
+    if (s->over) {
+        if (s->winner == 0)
+            return 0.0;
+        return s->winner == me ? WIN_SCORE : -WIN_SCORE;
+    }
+    return (double)s->handSize[2 - me] - (double)s->handSize[me - 1];
+}
+
+static double expectimax(GameState* s, int depth, int me, TransTable* tt);
+
+/* one node's children: apply, recurse, undo */
+static double expand(GameState* s, int depth, int me, TransTable* tt)
+{
+    int moves[GAMESTATE_MAX_MOVES];
+    int n = gamestate_legal_moves(s, moves);
+    GameUndo undo;
+
+    if (moves[0] == MOVE_DRAW) {
+        /* chance node: every card the hidden pile holds, by how many it holds */
+        double total = 0.0;
+        uint32_t hidden = s->hiddenSize;
+        for (int k = 0; k < GAMESTATE_SLOTS; k++) {
+            if (s->hidden[k] == 0)
+                continue;
+            double p = (double)s->hidden[k] / (double)hidden;
+            gamestate_apply_draw(s, (Card){ (uint8_t)k }, &undo);
+            total += p * expectimax(s, depth - 1, me, tt);
+            gamestate_undo(s, &undo);
+        }
+        return total;
+    }
+
+    int maximize = s->turn == me;
+    double best = maximize ? -INFINITY : INFINITY;
+    for (int i = 0; i < n; i++) {
+        gamestate_apply(s, moves[i], NULL, &undo);
+        double v = expectimax(s, depth - 1, me, tt);
+        gamestate_undo(s, &undo);
+        if (maximize ? v > best : v < best)
+            best = v;
+    }
+    return best;
+}
+
+/* search one state in place, through the table if there is one. The game
+ * is zero-sum, so entries hold seat 1's value and seat 2 negates it: both
+ * players can share a table. The depth is part of the key, so a cached
+ * value is exactly what the search would have returned. */
+static double expectimax(GameState* s, int depth, int me, TransTable* tt)
+{
+    if (s->over || depth == 0)
+        return evaluate(s, me);
+    if (!tt || depth < TT_MIN_DEPTH)
+        return expand(s, depth, me, tt);
+
+    double sign = me == 1 ? 1.0 : -1.0;
+    double value;
+    uint64_t key = gamestate_hash(s) + (uint64_t)depth * TT_DEPTH_KEY;
+    if (tt_probe(tt, key, depth, &value))
+        return sign * value;
+
+    value = expand(s, depth, me, tt);
+    tt_store(tt, key, depth, sign * value);
+    return value;
+}
+
+static int choose_expectimax(const Strategy* self, const GameState* s, Rng* rng)
+{
+    int moves[GAMESTATE_MAX_MOVES];
+    int n = gamestate_legal_moves(s, moves);
+    (void)rng;
+    if (n == 1)
+        return moves[0];    /* a forced move needs no search */
+
+    TransTable* tt = self->ctx;
+    if (tt)
+        tt_new_generation(tt);
+
+    GameState work = *s;
+    GameUndo undo;
+    int best = moves[0];
+    double bestValue = -INFINITY;
+    for (int i = 0; i < n; i++) {
+        gamestate_apply(&work, moves[i], NULL, &undo);
+        double v = expectimax(&work, self->depth - 1, s->turn, tt);
+        gamestate_undo(&work, &undo);
+        if (v > bestValue) {
+            bestValue = v;
+            best = moves[i];
+        }
+    }
+    return best;
+}
+
+/* ---------------- MCTS ---------------- */
+
+/* one tree node: the move that led here and who made it */
+typedef struct {
+    int move;
+    int parent;
+    int child;          /* first child, -1 if none */
+    int sibling;        /* next child of the same parent, -1 if none */
+    int mover;          /* seat that made move */
+    uint32_t visits;
+    double reward;      /* sum of playout results for mover */
+} MctsNode;
+
+/* play random moves to the end (or the turn cap); result for seat 1 */
+static double rollout(GameState* s, Rng* rng)
+{
+    int moves[GAMESTATE_MAX_MOVES];
+    for (int t = 0; t < ROLLOUT_TURNS && !s->over; t++) {
+        int n = gamestate_legal_moves(s, moves);
+        gamestate_apply(s, moves[rng_bounded(rng, (uint32_t)n)], rng, NULL);
+    }
+    if (!s->over || s->winner == 0)
+        return 0.5;
+    return s->winner == 1 ? 1.0 : 0.0;
+}
+
+/* child of node for move, or -1 */
+static int find_child(const MctsNode* nodes, int node, int move)
+{
+    for (int c = nodes[node].child; c >= 0; c = nodes[c].sibling) {
+        if (nodes[c].move == move)
+            return c;
+    }
+    return -1;
+}
+
+static int choose_mcts(const Strategy* self, const GameState* s, Rng* rng)
+{
+    int moves[GAMESTATE_MAX_MOVES];
+    if (gamestate_legal_moves(s, moves) == 1)
+        return moves[0];
+    int choice = moves[0];  /* moves is reused below */
+
+    int capacity = self->iterations + 1;
+    MctsNode* nodes = malloc(sizeof(MctsNode) * (size_t)capacity);
+    if (!nodes) {
+        fprintf(stderr, "Memory allocation failed in choose_mcts()\n");
+        exit(EXIT_FAILURE);
+    }
+    nodes[0] = (MctsNode){ 0, -1, -1, -1, 0, 0, 0.0 };
+    int used = 1;
+
+    for (int it = 0; it < self->iterations; it++) {
+        GameState work = *s;
+        int node = 0;
+
+        /* select down the tree, expanding the first move it has not tried */
+        while (!work.over) {
+            int m = gamestate_legal_moves(&work, moves);
+            int untried = 0, hasUntried = 0, best = -1;
+            double bestScore = -INFINITY;
+            double logVisits = log((double)nodes[node].visits + 1.0);
+
+            for (int i = 0; i < m; i++) {
+                int c = find_child(nodes, node, moves[i]);
+                if (c < 0) {
+                    untried = moves[i];     /* may be MOVE_DRAW, so keep a flag */
+                    hasUntried = 1;
+                    break;
+                }
+                double score = nodes[c].reward / nodes[c].visits
+                    + UCT_C * sqrt(logVisits / nodes[c].visits);
+                if (score > bestScore) {
+                    bestScore = score;
+                    best = c;
+                }
+            }
+
+            if (hasUntried && used < capacity) {
+                int c = used++;
+                nodes[c] = (MctsNode){ untried, node, -1, nodes[node].child, work.turn, 0, 0.0 };
+                nodes[node].child = c;
+                gamestate_apply(&work, untried, rng, NULL);
+                node = c;
+                break;
+            }
+            if (best < 0)
+                break;      /* out of nodes: play out from here */
+            gamestate_apply(&work, nodes[best].move, rng, NULL);
+            node = best;
+        }
+
+        double result = rollout(&work, rng);
+        for (; node >= 0; node = nodes[node].parent) {
+            nodes[node].visits++;
+            nodes[node].reward += nodes[node].mover == 1 ? result : 1.0 - result;
+        }
+    }
+
+    /* the most visited move is the most trusted */
+    uint32_t bestVisits = 0;
+    for (int c = nodes[0].child; c >= 0; c = nodes[c].sibling) {
+        if (nodes[c].visits > bestVisits) {
+            bestVisits = nodes[c].visits;
+            choice = nodes[c].move;
+        }
+    }
+    free(nodes);
+    return choice;
+}
+
+/* ---------------- registry ---------------- */
+
+const Strategy strategy_greedy = { "greedy", choose_greedy, 0, 0, NULL };
+const Strategy strategy_random = { "random", choose_random, 0, 0, NULL };
+const Strategy strategy_expectimax = { "expectimax", choose_expectimax, 3, 0, NULL };
+const Strategy strategy_mcts = { "mcts", choose_mcts, 0, 1000, NULL };
+
+static const Strategy* const builtins[] = {
+    &strategy_greedy, &strategy_random, &strategy_expectimax, &strategy_mcts
+};
+
+/* Find by name */
+const Strategy* strategy_find(const char* name)
+{
+    for (size_t i = 0; i < sizeof(builtins) / sizeof(builtins[0]); i++) {
+        if (strcmp(builtins[i]->name, name) == 0)
+            return builtins[i];
+    }
+    return NULL;
+}
+
+/* Snapshot the game, choose, and map the choice back to a hand index */
+int strategy_game_move(const Strategy* st, Game* g, Rng* rng)
+{
+    GameState s;
+    if (!gamestate_from_game(&s, g))
+        return game_choose_move(g);
+    return gamestate_game_move(g, st->choose(st, &s, rng));
+}
@@ -0,0 +1,56 @@
+/**
+* @file strategy.h
+* @brief Pluggable players that pick a move from a GameState.
+*
+* A Strategy is a choose function plus the knobs the shipped players use;
+* a custom player fills in its own choose and ctx. Four come built in:
+*   greedy      the built-in policy: lowest playable card, else draw/pass
+*   random      a uniformly random legal move
+*   expectimax  depth-limited search that averages over every card a draw
+*               could bring, scoring leaves by hand-size difference; with
+*               a TransTable in ctx, positions reached twice are searched once
+*   mcts        UCT over sampled draws with random playouts; draws are
+*               re-sampled on every iteration (open-loop tree)
+* Search players see both hands, so they play the full-information game;
+* only the hidden pile is treated as unknown.
+*/
+#ifndef STRATEGY_H
+#define STRATEGY_H
+
+#include "gameState.h"
+
+
+/**
+* @struct Strategy
+* @brief One kind of player.
+*/
+typedef struct Strategy {
+	const char* name;
+	int (*choose)(const struct Strategy* self, const GameState* s, Rng* rng); // A legal GameState move
+	int depth; // Expectimax plies
+	int iterations; // MCTS iterations per decision
+	void* ctx; // Expectimax: a shared TransTable (transTable.h) or NULL; free for custom strategies
+} Strategy;
+
+
+extern const Strategy strategy_greedy;
+extern const Strategy strategy_random;
+extern const Strategy strategy_expectimax;
+extern const Strategy strategy_mcts;
+
+
+/**
+* @brief Look a built-in strategy up by name.
+* @return The strategy, or NULL if there is none by that name.
+*/
+const Strategy* strategy_find(const char* name);
+
+
+/**
+* @brief Ask a strategy for g->turn's move in a running Game.
+* @return A game_apply() move. Games with more than GAMESTATE_MAX_PACKS
+*         packs fall back to game_choose_move().
+*/
+int strategy_game_move(const Strategy* st, Game* g, Rng* rng);
+
+#endif
@@ -1,20 +1,874 @@
-#include "CardDeck.h"
-#include <stdio.h>
-
-int main()
-{
-    CardDeck deck = createDeck(1);
-    printf("Created deck with %d cards.\n", deck.size);
-
-    shuffleDeck(&deck);
-    printf("Deck shuffled.\n");
-
-    bubbleSortDeck(&deck);
-    printf("Deck sorted.\n");
-
-    printDeck(&deck);
-
-    freeDeck(&deck);
-    return 0;
-}
-
+/*
+ * Smoke demo plus self-checks. Build it like menu.c, with one deck backend:
+ *   array (cardDeck.c):           default
+ *   linked list (carddeck.c):     -DDECK_BACKEND_LIST
+ *   ring buffer (carddeckRing.c): -DDECK_BACKEND_LIST -DCARDDECK_RING
+ * Prints one line per group of checks and exits 1 if any check failed.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "deck.h"
+#include "gameBatch.h"
+#include "gameState.h"
+#include "matchScan.h"
+#include "replay.h"
+#include "snapshot.h"
+#include "shoe.h"
+#include "shuffle.h"
+#include "transTable.h"
+
+static int failures;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("  FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+/* 1 if deck holds exactly model[0..n), top first */
+static int deck_equals(const CardDeck* deck, const Card* model, int64_t n)
+{
+    if (carddeck_size(deck) != n)
+        return 0;
+    if (n == 0)
+        return 1;
+    Card* cards = carddeck_to_array(deck);
+    int same = cards && memcmp(cards, model, (size_t)n) == 0;
+    free(cards);
+    return same;
+}
+
+#if defined(DECK_BACKEND_LIST)
+
+/* the i-th card of a pack, so small test decks hold distinct cards */
+static Card nth_card(int64_t i)
+{
+    return card_create((Suit)(i / 13 % 4), (Rank)(TWO + i % 13));
+}
+
+
+/* ---------------- deque edge cases ---------------- */
+
+/* n cards first..first+n-1, top first, with the top `shift` cards cycled to
+ * the bottom so that a ring buffer's cards, or the free slots after them,
+ * run past its last slot */
+static void make_wrapped(CardDeck* deck, Card* model, int64_t first, int64_t n, int64_t shift)
+{
+    initCardDeck(deck);
+    for (int64_t i = 0; i < n; i++)
+        addCardBottom(deck, nth_card(first + i));
+    for (int64_t i = 0; i < shift; i++) {
+        Card c;
+        removeTopCard(deck, &c);
+        addCardBottom(deck, c);
+    }
+    for (int64_t i = 0; i < n; i++)
+        model[i] = nth_card(first + (i + shift) % n);
+#if defined(CARDDECK_RING)
+    CHECK(deck->head > 0 && deck->head + deck->size != deck->capacity);
+
+#endif
+}
+
+static void check_deque_wrap(void)
+{
+    /* full ring (16 of 16) and part-full ring (12 of 16) */
+    static const int64_t sizes[2] = { 16, 12 };
+    static const int64_t shifts[2] = { 5, 7 };
+    Card model[64], out[64];
+    CardDeck deck, dst;
+    int before = failures;
+
+    for (int s = 0; s < 2; s++) {
+        int64_t n = sizes[s];
+
+        /* removal at every index: each side of the gap, across the wrap */
+        for (int64_t index = 0; index < n; index++) {
+            Card c;
+            make_wrapped(&deck, model, 0, n, shifts[s]);
+            CHECK(removeCardAt(&deck, index, &c) && c.bits == model[index].bits);
+            memmove(model + index, model + index + 1, (size_t)(n - index - 1));
+            CHECK(deck_equals(&deck, model, n - 1));
+            freeCardDeck(&deck);
+        }
+
+        /* dealing a run that crosses the wrap, in both orders */
+        for (int roundRobin = 0; roundRobin < 2; roundRobin++) {
+            make_wrapped(&deck, model, 0, n, shifts[s]);
+            CHECK(dealCards(&deck, 2, 5, roundRobin, out));
+            for (int i = 0; i < 10; i++) {
+                int slot = roundRobin ? (i % 2) * 5 + i / 2 : i;
+                CHECK(out[slot].bits == model[i].bits);
+            }
+            CHECK(deck_equals(&deck, model + 10, n - 10));
+            freeCardDeck(&deck);
+        }
+
+        /* splicing into an empty deck and into a wrapped one with room */
+        for (int keep = 0; keep < 4; keep += 3) {
+            Card dstModel[64];
+
+            make_wrapped(&deck, model, 0, n, shifts[s]);
+            initCardDeck(&dst);
+            spliceCards(&deck, keep, &dst);
+            CHECK(deck_equals(&deck, model, keep));
+            CHECK(deck_equals(&dst, model + keep, n - keep));
+            freeCardDeck(&deck);
+            freeCardDeck(&dst);
+
+            /* 20 of 32 slots: dst's cards wrap, then its free slots do */
+            for (int64_t dstShift = 15; dstShift > 0; dstShift -= 10) {
+                make_wrapped(&deck, model, 0, n, shifts[s]);
+                make_wrapped(&dst, dstModel, 20, 20, dstShift);
+                spliceCards(&deck, keep, &dst);
+                memcpy(dstModel + 20, model + keep, (size_t)(n - keep));
+                CHECK(deck_equals(&deck, model, keep));
+                CHECK(deck_equals(&dst, dstModel, 20 + n - keep));
+                freeCardDeck(&deck);
+                freeCardDeck(&dst);
+            }
+        }
+    }
+    printf("deque wrap-around: %s\n", failures > before ? "FAILED" : "ok");
+}
+
+#endif
+
+
+/* ---------------- dealing ---------------- */
+
+static void check_deal(void)
+{
+    int before = failures;
+
+    for (int order = 0; order < 2; order++) {
+        DealOrder how = order ? DEAL_ROUND_ROBIN : DEAL_BLOCK;
+        CardDeck deck;
+        Card out[40], top;
+        Rng rng;
+
+        carddeck_init_packs(&deck, 1);
+        rng_seed(&rng, 3);
+        carddeck_shuffle(&deck, &rng);
+        Card* model = carddeck_to_array(&deck);
+
+        /* three hands of five off the top */
+        CHECK(carddeck_deal(&deck, 3, 5, how, out));
+        for (int i = 0; i < 15; i++) {
+            int slot = how == DEAL_ROUND_ROBIN ? (i % 3) * 5 + i / 3 : i;
+            CHECK(out[slot].bits == model[i].bits);
+        }
+        CHECK(carddeck_size(&deck) == 52 - 15);
+        CHECK(carddeck_peek_top(&deck, &top) && top.bits == model[15].bits);
+        CHECK(!carddeck_deal(&deck, 5, 8, how, out));   /* 40 of 37 */
+        CHECK(carddeck_size(&deck) == 52 - 15);
+
+        free(model);
+        carddeck_free(&deck);
+    }
+    printf("dealing: %s\n", failures > before ? "FAILED" : "ok");
+}
+
+
+/* ---------------- shoes ---------------- */
+
+/* chi-square of kind counts against an even spread, 51 degrees of freedom */
+static double shoe_chi_square(const uint64_t* seen, uint64_t draws)
+{
+    double expect = (double)draws / SHOE_KINDS, chi = 0;
+    for (int k = 0; k < SHOE_KINDS; k++)
+        chi += ((double)seen[k] - expect) * ((double)seen[k] - expect) / expect;
+    return chi;
+}
+
+static void check_shoe(void)
+{
+    enum { DRAWS = 52 * 1000 };
+    const double limit = 100;   /* p < 1e-4 at 51 degrees of freedom */
+    Shoe shoe;
+    Rng rng;
+    Card c, hand[8];
+    uint64_t seen[SHOE_KINDS];
+    int before = failures;
+
+    rng_seed(&rng, 17);
+
+    /* drawing a shoe dry hands out every card of its packs exactly once */
+    shoe_init(&shoe, 3);
+    memset(seen, 0, sizeof(seen));
+    for (int i = 0; i < 3 * SHOE_KINDS; i++) {
+        CHECK(shoe_draw(&shoe, &rng, &c));
+        seen[card_suit(c) * 13 + card_rank(c) - TWO]++;
+    }
+    for (int k = 0; k < SHOE_KINDS; k++)
+        CHECK(seen[k] == 3);
+    CHECK(shoe_is_empty(&shoe) && !shoe_draw(&shoe, &rng, &c));
+    CHECK(!shoe_deal(&shoe, &rng, hand, 1));
+
+    /* the first card of a fresh two-pack shoe is any kind alike */
+    memset(seen, 0, sizeof(seen));
+    for (int i = 0; i < DRAWS; i++) {
+        shoe_init(&shoe, 2);
+        shoe_draw(&shoe, &rng, &c);
+        seen[card_suit(c) * 13 + card_rank(c) - TWO]++;
+    }
+    CHECK(shoe_chi_square(seen, DRAWS) < limit);
+
+    /* same at the largest shoe, whose tree sums run up to 2^64 */
+    shoe_init(&shoe, SHOE_MAX_PACKS);
+    CHECK(shoe_size(&shoe) == SHOE_MAX_PACKS * SHOE_KINDS);
+    memset(seen, 0, sizeof(seen));
+    for (int i = 0; i < DRAWS; i++) {
+        shoe_draw(&shoe, &rng, &c);
+        seen[card_suit(c) * 13 + card_rank(c) - TWO]++;
+    }
+    CHECK(shoe_chi_square(seen, DRAWS) < limit);
+    CHECK(shoe_size(&shoe) == SHOE_MAX_PACKS * SHOE_KINDS - DRAWS);
+    for (int k = 0; k < SHOE_KINDS; k++)
+        CHECK(shoe.count[k] == SHOE_MAX_PACKS - seen[k]);
+
+    printf("shoe draws: %s\n", failures > before ? "FAILED" : "ok");
+}
+
+/* ---------------- match scans ---------------- */
+
+/* every kernel against a plain loop, for every length up to 97 and every
+ * top card; the cards after the scanned run all match, so a kernel that
+ * reads past its count miscounts */
+static void check_match_scan(void)
+{
+    static const MatchKernel kernels[3] = { MATCH_KERNEL_SCALAR, MATCH_KERNEL_SSE2, MATCH_KERNEL_AVX2 };
+    enum { MAX_LEN = 97 };
+    Card cards[MAX_LEN], buf[MAX_LEN + 40];
+    int want[MAX_LEN], got[MAX_LEN];
+    char tested[32] = "";
+    Rng rng;
+    int before = failures;
+
+    rng_seed(&rng, 11);
+    for (int i = 0; i < MAX_LEN; i++)
+        cards[i] = card_create((Suit)rng_bounded(&rng, 4), (Rank)(TWO + rng_bounded(&rng, 13)));
+
+    for (int k = 0; k < 3; k++) {
+        int mismatches = 0;
+        if (!match_select(kernels[k]))
+            continue;   /* not in this build or on this CPU */
+        strcat(tested, " ");
+        strcat(tested, match_kernel_name());
+
+        for (int len = 0; len <= MAX_LEN; len++) {
+            for (int t = 0; t < 52; t++) {
+                Card top = card_create((Suit)(t / 13), (Rank)(TWO + t % 13));
+                Card* run = buf + 1;    /* off any vector alignment */
+                int first = -1, count = 0;
+                uint32_t mask = 0;
+
+                memcpy(run, cards, (size_t)len);
+                for (int i = len; i < MAX_LEN + 39; i++)
+                    run[i] = top;
+                for (int i = 0; i < len; i++) {
+                    if (card_matches(cards[i], top)) {
+                        if (first < 0)
+                            first = i;
+                        if (i < 32)
+                            mask |= 1u << i;
+                        want[count++] = i;
+                    }
+                }
+
+                mismatches += match_first(run, len, top) != first;
+                mismatches += match_count(run, len, top) != count;
+                mismatches += match_all(run, len, top, got) != count
+                    || memcmp(got, want, sizeof(int) * (size_t)count) != 0;
+                mismatches += match_mask32(run, len, top) != mask;
+            }
+        }
+        CHECK(mismatches == 0);
+    }
+    match_select(MATCH_KERNEL_AUTO);
+    printf("match scan (%s): %s\n", tested + 1, failures > before ? "FAILED" : "ok");
+}
+
+
+/* ---------------- parallel bucket shuffle ---------------- */
+
+/* the shuffle only moves bytes, so test cards need not be valid cards */
+static void fill_bytes(Card* cards, int64_t n, int values)
+{
+    for (int64_t i = 0; i < n; i++)
+        cards[i] = (Card){ (uint8_t)(i % values) };
+}
+
+static void check_bucket_shuffle(void)
+{
+    /* three full 1M-card label chunks and part of a fourth */
+    const int64_t n = ((int64_t)3 << 20) + 12345;
+    static const int threads[3] = { 1, 2, 5 };
+    Card* first = malloc((size_t)n);
+    Card* cards = malloc((size_t)n);
+    int64_t want[256] = { 0 }, got[256] = { 0 }, fixed = 0;
+    int before = failures;
+
+    if (!first || !cards) {
+        printf("  FAILED: out of memory\n");
+        failures++;
+        free(first);
+        free(cards);
+        return;
+    }
+
+    /* a permutation of the input, the same one on any number of threads */
+    for (int t = 0; t < 3; t++) {
+        Card* out = t == 0 ? first : cards;
+        Rng rng;
+        fill_bytes(out, n, 251);
+        rng_seed(&rng, 42);
+        card_shuffle_threads(out, n, &rng, threads[t]);
+        if (t > 0)
+            CHECK(memcmp(out, first, (size_t)n) == 0);
+    }
+    fill_bytes(cards, n, 251);
+    for (int64_t i = 0; i < n; i++) {
+        want[cards[i].bits]++;
+        got[first[i].bits]++;
+        fixed += first[i].bits == cards[i].bits;
+    }
+    CHECK(memcmp(want, got, sizeof(want)) == 0);
+    CHECK(fixed < n / 100);     /* about n / 251 stay put by chance */
+    free(first);
+    free(cards);
+
+    /* every card equally likely in every slot: 64 cards through the bucket
+     * path 25600 times, 400 expected per (card, slot) with sigma 20 */
+    enum { CARDS = 64, TRIALS = 25600 };
+    static uint32_t hits[CARDS][CARDS];
+    Card small[CARDS];
+    uint64_t chi2x400 = 0;      /* chi-square times the expected count */
+    int permutations = 1;
+    Rng rng;
+
+    shuffle_set_parallel_min(16);
+    rng_seed(&rng, 7);
+    for (int t = 0; t < TRIALS; t++) {
+        uint64_t seen = 0;
+        fill_bytes(small, CARDS, CARDS);
+        card_shuffle_threads(small, CARDS, &rng, 1);
+        for (int slot = 0; slot < CARDS; slot++) {
+            hits[small[slot].bits][slot]++;
+            seen |= 1ULL << small[slot].bits;
+        }
+        permutations &= seen == ~0ULL;
+    }
+    shuffle_set_parallel_min(0);
+    CHECK(permutations);
+
+    int outliers = 0;
+    for (int c = 0; c < CARDS; c++) {
+        for (int slot = 0; slot < CARDS; slot++) {
+            int64_t d = (int64_t)hits[c][slot] - TRIALS / CARDS;
+            outliers += d < -120 || d > 120;    /* 6 sigma */
+            chi2x400 += (uint64_t)(d * d);
+        }
+    }
+    CHECK(outliers == 0);
+    /* 63 * 63 degrees of freedom: mean 3969, sd 89; allow 6 sd */
+    CHECK(chi2x400 < (uint64_t)(3969 + 6 * 89) * (TRIALS / CARDS));
+
+    /* the reversed shuffle equals reverse, shuffle, reverse, on both paths */
+    for (int64_t threshold = 0; threshold <= 16; threshold += 16) {
+        Card a[200], b[200];
+        Rng ra, rb;
+        fill_bytes(a, 200, 200);
+        for (int i = 0; i < 200; i++)
+            b[i] = a[199 - i];
+        rng_seed(&ra, 5);
+        rng_seed(&rb, 5);
+        shuffle_set_parallel_min(threshold);
+        card_shuffle_reversed(a, 200, &ra);
+        card_shuffle(b, 200, &rb);
+        shuffle_set_parallel_min(0);
+        int same = 1;
+        for (int i = 0; i < 200; i++)
+            same &= a[i].bits == b[199 - i].bits;
+        CHECK(same);
+    }
+    printf("bucket shuffle: %s\n", failures > before ? "FAILED" : "ok");
+}
+
+
+/* ---------------- game state apply and undo ---------------- */
+
+static void check_apply_undo(void)
+{
+    enum { PLIES = 300 };
+    static GameState path[PLIES + 1];   /* path[k]: the state after k moves */
+    static uint64_t hashes[PLIES + 1];
+    static GameUndo undos[PLIES];
+    int mismatches = 0, hashMismatches = 0, refills = 0;
+    Game game;
+    Rng rng;
+    int before = failures;
+
+    game.verbosity = VERBOSITY_QUIET;
+    game.interactive = 0;
+    rng_seed(&rng, 99);
+
+    for (int trial = 0; trial < 60; trial++) {
+        GameState s;
+        int plies = 0;
+
+        /* one to three packs, decks and shoes, some way into the game */
+        game.use_shoe = trial % 2;
+        rng_seed(&game.rng, (uint64_t)trial);
+        game_start(&game, 1 + trial % 3);
+        for (int t = (int)rng_bounded(&rng, 60); t > 0 && !game.over; t--)
+            game_step(&game);
+        CHECK(gamestate_from_game(&s, &game));
+        CHECK(gamestate_hash(&s) == game_hash(&game));
+        game_free(&game);
+
+        /* random moves forward, remembering every state... */
+        memcpy(&path[0], &s, sizeof(s));
+        hashes[0] = gamestate_hash(&s);
+        while (plies < PLIES && !s.over) {
+            int moves[GAMESTATE_MAX_MOVES];
+            int n = gamestate_legal_moves(&s, moves);
+            gamestate_apply(&s, moves[rng_bounded(&rng, (uint32_t)n)], &rng, &undos[plies]);
+            refills += undos[plies].refilled;
+            plies++;
+            memcpy(&path[plies], &s, sizeof(s));
+            hashes[plies] = gamestate_hash(&s);
+        }
+
+        /* ...then undone in reverse, byte for byte */
+        while (plies > 0) {
+            gamestate_undo(&s, &undos[--plies]);
+            mismatches += memcmp(&s, &path[plies], sizeof(s)) != 0;
+            hashMismatches += gamestate_hash(&s) != hashes[plies];
+        }
+    }
+    CHECK(mismatches == 0);
+    CHECK(hashMismatches == 0);
+    CHECK(refills > 0);     /* the walks reached the refill undo path */
+
+    /* a pass moves no card, so only the pass count tells the states apart */
+    GameState passed = path[0];
+    passed.passes = (uint8_t)!passed.passes;
+    CHECK(gamestate_hash(&passed) != gamestate_hash(&path[0]));
+
+    printf("game state apply/undo: %s\n", failures > before ? "FAILED" : "ok");
+}
+
+/* ---------------- snapshots ---------------- */
+
+#define SNAPSHOT_TMP "test_snapshot.tmp"
+
+/* the whole file in a malloc'd buffer, or NULL */
+static unsigned char* read_file(const char* path, long* size)
+{
+    FILE* f = fopen(path, "rb");
+    unsigned char* data = NULL;
+
+    if (f && fseek(f, 0, SEEK_END) == 0 && (*size = ftell(f)) > 0 && fseek(f, 0, SEEK_SET) == 0) {
+        data = malloc((size_t)*size);
+        if (data && fread(data, 1, (size_t)*size, f) != (size_t)*size) {
+            free(data);
+            data = NULL;
+        }
+    }
+    if (f)
+        fclose(f);
+    return data;
+}
+
+static int write_file(const char* path, const unsigned char* data, long size)
+{
+    FILE* f = fopen(path, "wb");
+    int ok = f && fwrite(data, 1, (size_t)size, f) == (size_t)size;
+    if (f && fclose(f) != 0)
+        ok = 0;
+    return ok;
+}
+
+/* 1 if a and b hold the same piles, hands and counters */
+static int games_equal(const Game* a, const Game* b)
+{
+    if (game_hash(a) != game_hash(b) || a->packs != b->packs || a->use_shoe != b->use_shoe
+        || a->turn != b->turn || a->passes != b->passes || a->winner != b->winner
+        || a->over != b->over || a->turns != b->turns || a->refills != b->refills)
+        return 0;
+    if (memcmp(&a->rng, &b->rng, sizeof(a->rng)) != 0
+        || (a->use_shoe && memcmp(a->shoe.count, b->shoe.count, sizeof(a->shoe.count)) != 0))
+        return 0;
+
+    const CardDeck* piles[2][2] = { { &a->hidden, &b->hidden }, { &a->played, &b->played } };
+    for (int i = 0; i < 2; i++) {
+        int64_t n = carddeck_size(piles[i][1]);
+        Card* cards = n ? carddeck_to_array(piles[i][1]) : NULL;
+        int same = deck_equals(piles[i][0], cards, n);
+        free(cards);
+        if (!same)
+            return 0;
+    }
+    for (int p = 0; p < 2; p++) {
+        const Hand* x = &a->players[p].hand;
+        const Hand* y = &b->players[p].hand;
+        if (x->size != y->size || (x->size && memcmp(x->cards, y->cards, (size_t)x->size) != 0))
+            return 0;
+    }
+    return 1;
+}
+
+/* flip one byte of the file at offset */
+static void damage_file(const char* path, long offset)
+{
+    long size;
+    unsigned char* data = read_file(path, &size);
+    if (data && offset < size) {
+        data[offset] ^= 0x5A;
+        write_file(path, data, size);
+    }
+    free(data);
+}
+
+static void check_snapshot(void)
+{
+    Snapshot snap;
+    Game game, loaded;
+    unsigned char* data;
+    long size;
+    int before = failures;
+
+    game.verbosity = loaded.verbosity = VERBOSITY_QUIET;
+    game.interactive = loaded.interactive = 0;
+
+    /* save, load and play on: decks and shoes, fresh and part-played */
+    for (int trial = 0; trial < 8; trial++) {
+        game.use_shoe = trial % 2;
+        rng_seed(&game.rng, (uint64_t)trial + 100);
+        game_start(&game, 1 + trial % 3);
+        for (int t = trial * 15; t > 0 && !game.over; t--)
+            game_step(&game);
+
+        CHECK(snapshot_save_game(SNAPSHOT_TMP, &game) == SNAPSHOT_OK);
+        CHECK(snapshot_open(&snap, SNAPSHOT_TMP, 1) == SNAPSHOT_OK);
+        CHECK(snapshot_load_game(&snap, &loaded) == SNAPSHOT_OK);
+        snapshot_close(&snap);
+        CHECK(games_equal(&game, &loaded));
+
+        while (game_step(&game))
+            ;
+        while (game_step(&loaded))
+            ;
+        CHECK(games_equal(&game, &loaded));
+        game_free(&game);
+        game_free(&loaded);
+    }
+
+    /* a saved running game to damage */
+    game.use_shoe = 0;
+    rng_seed(&game.rng, 1);
+    game_start(&game, 1);
+    CHECK(snapshot_save_game(SNAPSHOT_TMP, &game) == SNAPSHOT_OK);
+    game_free(&game);
+    data = read_file(SNAPSHOT_TMP, &size);
+    CHECK(data != NULL);
+
+    if (data) {
+        /* one flipped payload byte fails the checksum, and only when verifying */
+        damage_file(SNAPSHOT_TMP, 40);
+        CHECK(snapshot_open(&snap, SNAPSHOT_TMP, 1) == SNAPSHOT_ECHECKSUM);
+        CHECK(snapshot_open(&snap, SNAPSHOT_TMP, 0) == SNAPSHOT_OK);
+        snapshot_close(&snap);
+
+        /* losing the end of the section table */
+        CHECK(write_file(SNAPSHOT_TMP, data, size - 5));
+        CHECK(snapshot_open(&snap, SNAPSHOT_TMP, 0) == SNAPSHOT_EFORMAT);
+        CHECK(write_file(SNAPSHOT_TMP, data, size - 24));
+        CHECK(snapshot_open(&snap, SNAPSHOT_TMP, 0) == SNAPSHOT_EFORMAT);
+
+        /* a running game with its played pile emptied: no top card */
+        const unsigned char* played;
+        uint64_t bytes;
+        CHECK(write_file(SNAPSHOT_TMP, data, size));
+        if (snapshot_open(&snap, SNAPSHOT_TMP, 0) == SNAPSHOT_OK) {
+            CHECK(snapshot_section(&snap, SNAP_PLAYED, 0, &played, &bytes) == SNAPSHOT_OK);
+            long table = (long)(snap.table - snap.base);
+            uint32_t sections = snap.sections;
+            snapshot_close(&snap);
+            for (uint32_t i = 0; i < sections; i++) {
+                /* entry: type, reserved, offset, length; zero the played length */
+                unsigned char* e = data + table + (long)i * 24;
+                if (e[0] == SNAP_PLAYED)
+                    memset(e + 16, 0, 8);
+            }
+            CHECK(write_file(SNAPSHOT_TMP, data, size));
+            CHECK(snapshot_open(&snap, SNAPSHOT_TMP, 0) == SNAPSHOT_OK);
+            CHECK(snapshot_load_game(&snap, &loaded) == SNAPSHOT_EFORMAT);
+            snapshot_close(&snap);
+        }
+        free(data);
+    }
+    remove(SNAPSHOT_TMP);
+    printf("snapshots: %s\n", failures > before ? "FAILED" : "ok");
+}
+
+/* ---------------- replay logs ---------------- */
+
+#define REPLAY_TMP "test_replay.tmp"
+
+static void check_replay(void)
+{
+    enum { GAMES = 6, SEEN = 64 };
+    static ReplayWriter writer;     /* holds a 64 KiB buffer */
+    static ReplayReader reader;
+    uint64_t hashes[GAMES][SEEN];   /* game_hash() after each of the first turns */
+    int turns[GAMES], winners[GAMES];
+    ReplayGame rg;
+    Game game;
+    unsigned char* data;
+    long size;
+    int before = failures;
+
+    memset(&game, 0, sizeof(game));
+    game.verbosity = VERBOSITY_QUIET;
+    remove(REPLAY_TMP);
+
+    /* log decks and shoes of one to three packs */
+    CHECK(replay_writer_open(&writer, REPLAY_TMP) == REPLAY_OK);
+    for (int n = 0; n < GAMES; n++) {
+        Rng start;
+        rng_seed(&game.rng, (uint64_t)n + 200);
+        start = game.rng;
+        game.use_shoe = n % 2;
+        game_start(&game, 1 + n % 3);
+        replay_write_start(&writer, &start, &game);
+        hashes[n][0] = game_hash(&game);
+        while (!game.over && game_step(&game) >= 0) {
+            replay_write_move(&writer, game.last_move);
+            if (game.turns < SEEN)
+                hashes[n][game.turns] = game_hash(&game);
+        }
+        replay_write_end(&writer, &game);
+        turns[n] = game.turns;
+        winners[n] = game.winner;
+        game_free(&game);
+    }
+    CHECK(replay_writer_close(&writer) == REPLAY_OK);
+
+    /* read back: same games, each replays cleanly and seeks to mid-game */
+    replay_game_init(&rg);
+    CHECK(replay_reader_open(&reader, REPLAY_TMP) == REPLAY_OK);
+    for (int n = 0; n < GAMES; n++) {
+        int seek = (turns[n] < SEEN ? turns[n] : SEEN - 1) / 2;
+        CHECK(replay_read_game(&reader, &rg) == 1);
+        CHECK(rg.packs == 1 + n % 3 && rg.use_shoe == n % 2);
+        CHECK(rg.count == turns[n] && rg.winner == winners[n]);
+        CHECK(replay_verify(&rg, 1) == REPLAY_OK);
+        CHECK(replay_seek(&rg, &game, seek) == REPLAY_OK);
+        CHECK(game.turns == seek && game_hash(&game) == hashes[n][seek]);
+        game_free(&game);
+    }
+    CHECK(replay_read_game(&reader, &rg) == 0);
+    replay_reader_close(&reader);
+
+    /* a log cut short in its last game reads the others, then fails */
+    data = read_file(REPLAY_TMP, &size);
+    CHECK(data && write_file(REPLAY_TMP, data, size - 3));
+    CHECK(replay_reader_open(&reader, REPLAY_TMP) == REPLAY_OK);
+    for (int n = 0; n < GAMES - 1; n++)
+        CHECK(replay_read_game(&reader, &rg) == 1);
+    CHECK(replay_read_game(&reader, &rg) == REPLAY_EFORMAT);
+    replay_reader_close(&reader);
+    free(data);
+
+    replay_game_free(&rg);
+    remove(REPLAY_TMP);
+    printf("replay logs: %s\n", failures > before ? "FAILED" : "ok");
+}
+
+/* ---------------- game batches ---------------- */
+
+/* a lane's hands, piles and top card hold exactly packs copies of each card */
+static int batch_lane_ok(const GameBatch* b, int lane)
+{
+    int64_t copies[CARD_KEYS] = { 0 };
+    const Card* hidden = b->hidden + (int64_t)lane * b->cap;
+    const Card* played = b->played + (int64_t)lane * b->cap;
+    int ok = 1;
+
+    for (int s = 0; s < 2; s++) {
+        const uint8_t* count = b->count[s] + (size_t)lane * 64;
+        int64_t held = 0;
+        for (int k = 0; k < 64; k++) {
+            held += count[k];
+            copies[k] += count[k];
+            ok &= (count[k] != 0) == cardset_contains(b->held[s][lane], (Card){ (uint8_t)k });
+        }
+        ok &= held == b->handSize[s][lane];
+    }
+    for (uint32_t i = 0; i < b->hiddenSize[lane]; i++)
+        copies[hidden[i].bits]++;
+    for (uint32_t i = 0; i < b->playedSize[lane]; i++)
+        copies[played[i].bits]++;
+    copies[b->top[lane].bits]++;
+
+    ok &= b->handSize[0][lane] + b->handSize[1][lane] + b->hiddenSize[lane]
+        + b->playedSize[lane] + 1 == (uint64_t)b->cap;
+    for (int s = 0; s < 4; s++)
+        for (int r = TWO; r <= ACE; r++)
+            ok &= copies[card_create((Suit)s, (Rank)r).bits] == b->packs;
+    return ok;
+}
+
+static void check_batch(void)
+{
+    enum { LANES = 5 };
+    static const uint64_t games[] = { 3, 5, 40 };   /* fewer, as many and more than lanes */
+    BatchResult done[LANES];
+    GameBatch b;
+    int before = failures;
+
+    for (int n = 0; n < 3; n++) {
+        uint64_t ended = 0;
+        int steps = 0;
+
+        CHECK(batch_init(&b, LANES, 1 + n) == 0);
+        rng_seed(&b.rng, (uint64_t)n + 300);
+        batch_start(&b, games[n]);
+        CHECK(batch_running(&b) == (games[n] < LANES ? (int)games[n] : LANES));
+
+        while (batch_running(&b) > 0 && steps++ < 1000000) {
+            uint32_t turns[LANES];
+            uint8_t idle[LANES];
+            int active = 0, got;
+
+            for (int i = 0; i < LANES; i++) {
+                turns[i] = b.turns[i];
+                idle[i] = !b.active[i];
+            }
+            got = batch_step(&b, done);
+            ended += (uint64_t)got;
+            for (int k = 0; k < got; k++)
+                CHECK(done[k].winner >= 0 && done[k].winner <= 2 && done[k].turns > 0);
+
+            for (int i = 0; i < LANES; i++) {
+                if (b.active[i]) {
+                    active++;
+                    CHECK(batch_lane_ok(&b, i));
+                }
+                else if (idle[i])
+                    CHECK(b.turns[i] == turns[i]);  /* masked out: untouched */
+            }
+            /* finished lanes are dealt again while games are left to
+             * start; after that they drop out */
+            CHECK(active == batch_running(&b) && (uint64_t)active == b.started - ended);
+            CHECK(b.started <= games[n]);
+            if (b.started < games[n])
+                CHECK(active == LANES);
+        }
+
+        CHECK(batch_running(&b) == 0);
+        CHECK(b.started == games[n] && ended == games[n]);
+        batch_free(&b);
+    }
+    printf("game batches: %s\n", failures > before ? "FAILED" : "ok");
+}
+
+/* ---------------- transposition table ---------------- */
+
+static int tt_holds(TransTable* t, uint64_t key, double value)
+{
+    double got = 0;
+    return tt_probe(t, key, 0, &got) && got == value;
+}
+
+static void check_trans_table(void)
+{
+    TransTable t;
+    double got = 0;
+    int before = failures;
+
+    /* one bucket, so every key competes for the same TT_BUCKET_SLOTS slots */
+    CHECK(tt_init(&t, sizeof(TTSlot) * TT_BUCKET_SLOTS, TT_REPLACE_DEPTH) == 0);
+    CHECK(t.mask == 0);
+
+    /* store and probe; a result searched shallower than asked is a miss */
+    tt_store(&t, 101, 3, 1.5);
+    CHECK(tt_probe(&t, 101, 3, &got) && got == 1.5);
+    CHECK(tt_probe(&t, 101, 2, &got) && got == 1.5);
+    CHECK(!tt_probe(&t, 101, 4, &got));
+    CHECK(!tt_probe(&t, 102, 0, &got));
+
+    /* the same key: a deeper result from this generation stays */
+    tt_store(&t, 101, 2, -1.0);
+    CHECK(tt_holds(&t, 101, 1.5));
+    tt_store(&t, 101, 6, 2.5);
+    CHECK(tt_probe(&t, 101, 6, &got) && got == 2.5);
+
+    /* a full bucket evicts an old generation's entry, deep as it is */
+    tt_clear(&t);
+    tt_store(&t, 1, 20, 1);
+    for (int g = 0; g < 3; g++)
+        tt_new_generation(&t);
+    tt_store(&t, 2, 4, 2);
+    tt_store(&t, 3, 4, 3);
+    tt_store(&t, 4, 4, 4);
+    tt_store(&t, 5, 2, 5);
+    CHECK(!tt_holds(&t, 1, 1));
+    CHECK(tt_holds(&t, 2, 2) && tt_holds(&t, 3, 3) && tt_holds(&t, 4, 4) && tt_holds(&t, 5, 5));
+
+    /* within a generation the shallowest entry goes */
+    tt_store(&t, 6, 1, 6);
+    CHECK(!tt_holds(&t, 5, 5));
+    CHECK(tt_holds(&t, 2, 2) && tt_holds(&t, 3, 3) && tt_holds(&t, 4, 4) && tt_holds(&t, 6, 6));
+    tt_free(&t);
+
+    /* replace-always lets a shallower result overwrite a deeper one */
+    CHECK(tt_init(&t, 1 << 16, TT_REPLACE_ALWAYS) == 0);
+    tt_store(&t, 77, 9, 1);
+    tt_store(&t, 77, 1, 2);
+    CHECK(tt_holds(&t, 77, 2));
+    tt_clear(&t);
+    CHECK(!tt_probe(&t, 77, 0, &got));
+    tt_free(&t);
+
+    printf("transposition table: %s\n", failures > before ? "FAILED" : "ok");
+}
+
+int main()
+{
+#if !defined(DECK_BACKEND_LIST)
+    CardDeck deck = createDeck(1);
+    printf("Created deck with %lld cards.\n", (long long)deck.size);
+
+    Rng rng;
+    rng_seed(&rng, (uint64_t)time(NULL));
+    shuffleDeck(&deck, &rng);
+    printf("Deck shuffled.\n");
+
+    bubbleSortDeck(&deck);
+    printf("Deck sorted.\n");
+
+    printDeck(&deck);
+
+    freeDeck(&deck);
+#else
+    check_deque_wrap();
+#endif
+    check_deal();
+    check_shoe();
+    check_match_scan();
+    check_bucket_shuffle();
+    check_apply_undo();
+    check_snapshot();
+    check_replay();
+    check_batch();
+    check_trans_table();
+
+    printf("%s\n", failures ? "SOME CHECKS FAILED" : "all checks passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,133 @@
+#include <stdlib.h>
+#include <string.h>
+#include "transTable.h"
+#include "perf.h"
+
+#define INFO_VALID (1ULL << 63)
+#define AGE_WEIGHT 8    /* a generation of age outweighs this many plies of depth */
+
+static inline uint64_t load(_Atomic uint64_t* w)
+{
+    return atomic_load_explicit(w, memory_order_relaxed);
+}
+
+static inline void put(_Atomic uint64_t* w, uint64_t v)
+{
+    atomic_store_explicit(w, v, memory_order_relaxed);
+}
+
+static inline int info_depth(uint64_t info)
+{
+    return (int)(info & 0xFF);
+}
+
+static inline unsigned info_generation(uint64_t info)
+{
+    return (unsigned)(info >> 8) & 0xFF;
+}
+
+/* Allocate the largest power-of-two bucket count that fits */
+int tt_init(TransTable* t, size_t bytes, TTPolicy policy)
+{
+    size_t bucket = sizeof(TTSlot) * TT_BUCKET_SLOTS;
+    size_t buckets = 1;
+
+    memset(t, 0, sizeof(*t));
+    while (buckets * 2 * bucket <= bytes)
+        buckets *= 2;
+
+    t->slots = calloc(buckets * TT_BUCKET_SLOTS, sizeof(TTSlot));
+    if (!t->slots)
+        return -1;
+    t->mask = buckets - 1;
+    t->policy = policy;
+    return 0;
+}
+
+/* Find the key in its bucket; torn slots fail the check and read as misses */
+int tt_probe(TransTable* t, uint64_t key, int depth, double* value)
+{
+    TTSlot* slot = t->slots + (key & t->mask) * TT_BUCKET_SLOTS;
+
+    PERF_COUNT(PERF_TT_PROBES, 1);
+    for (int i = 0; i < TT_BUCKET_SLOTS; i++) {
+        uint64_t check = load(&slot[i].check);
+        uint64_t bits = load(&slot[i].value);
+        uint64_t info = load(&slot[i].info);
+
+        if (!(info & INFO_VALID) || (check ^ bits ^ info) != key)
+            continue;
+        if (info_depth(info) < depth)
+            return 0;
+        memcpy(value, &bits, sizeof(*value));
+        PERF_COUNT(PERF_TT_HITS, 1);
+        return 1;
+    }
+    return 0;
+}
+
+/* Pick the slot to write: the key's own, an empty one, or the policy's victim */
+void tt_store(TransTable* t, uint64_t key, int depth, double value)
+{
+    TTSlot* slot = t->slots + (key & t->mask) * TT_BUCKET_SLOTS;
+    unsigned gen = atomic_load_explicit(&t->generation, memory_order_relaxed) & 0xFF;
+    int target = -1, victim = -1, victimScore = 0;
+
+    if (depth > TT_MAX_DEPTH)
+        depth = TT_MAX_DEPTH;
+
+    for (int i = 0; i < TT_BUCKET_SLOTS; i++) {
+        uint64_t info = load(&slot[i].info);
+        if (!(info & INFO_VALID)) {
+            if (target < 0)
+                target = i;     /* keep looking: the key may be further on */
+            continue;
+        }
+        if ((load(&slot[i].check) ^ load(&slot[i].value) ^ info) == key) {
+            /* a deeper result from this generation is worth more than ours */
+            if (t->policy == TT_REPLACE_DEPTH && info_depth(info) > depth
+                && info_generation(info) == gen)
+                return;
+            target = i;
+            break;
+        }
+        if (t->policy == TT_REPLACE_DEPTH) {
+            int age = (int)((gen - info_generation(info)) & 0xFF);
+            int score = info_depth(info) - AGE_WEIGHT * age;
+            if (victim < 0 || score < victimScore)
+                victim = i, victimScore = score;
+        }
+    }
+
+    if (target >= 0)
+        victim = target;
+    else if (victim < 0)    /* TT_REPLACE_ALWAYS with a full bucket */
+        victim = (int)(key >> 62) & (TT_BUCKET_SLOTS - 1);
+
+    uint64_t bits;
+    uint64_t info = INFO_VALID | (uint64_t)gen << 8 | (uint64_t)depth;
+    memcpy(&bits, &value, sizeof(bits));
+    put(&slot[victim].value, bits);
+    put(&slot[victim].info, info);
+    put(&slot[victim].check, key ^ bits ^ info);
+}
+
+/* Older entries become fair game for the depth policy */
+void tt_new_generation(TransTable* t)
+{
+    atomic_fetch_add_explicit(&t->generation, 1, memory_order_relaxed);
+}
+
+/* Zero every slot */
+void tt_clear(TransTable* t)
+{
+    memset(t->slots, 0, (size_t)(t->mask + 1) * TT_BUCKET_SLOTS * sizeof(TTSlot));
+    atomic_store(&t->generation, 0);
+}
+
+/* Free the slots */
+void tt_free(TransTable* t)
+{
+    free(t->slots);
+    memset(t, 0, sizeof(*t));
+}
@@ -0,0 +1,102 @@
+/**
+* @file transTable.h
+* @brief Fixed-size cache of search results keyed by position hash.
+*
+* A transposition table maps a 64-bit position key (zobrist.h) to the
+* value a search found for it and the depth it searched to. The table is a
+* power-of-two array of buckets of TT_BUCKET_SLOTS slots; a key may live in
+* any slot of the bucket its low bits pick, and the replacement policy
+* decides which slot a new entry evicts when the bucket is full. Memory is
+* fixed at tt_init(): the table never grows.
+*
+* Any number of threads may probe and store at once without locks. A slot
+* is three words written one after another, the last being the key XORed
+* with the other two. A reader accepts a slot only if that check still
+* matches, so a slot torn by two writers racing reads as a miss instead of
+* a wrong value. A lost store just costs a later re-search.
+*/
+#ifndef TRANSTABLE_H
+#define TRANSTABLE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TT_BUCKET_SLOTS 4 // Slots a key may occupy
+#define TT_MAX_DEPTH 255 // Deepest depth a slot records
+
+
+/**
+* @enum TTPolicy
+* @brief Which slot a store evicts when its bucket is full.
+*/
+typedef enum {
+	TT_REPLACE_ALWAYS = 0, // Newest wins: the slot the key's high bits pick
+	TT_REPLACE_DEPTH // Keep deep results; entries from older generations age out first
+} TTPolicy;
+
+
+/**
+* @struct TTSlot
+* @brief One entry. info is 0 for an empty slot.
+*/
+typedef struct {
+	_Atomic uint64_t check; // key ^ value ^ info
+	_Atomic uint64_t value; // Bits of the stored double
+	_Atomic uint64_t info; // Valid bit 63, generation in bits 8-15, depth in bits 0-7
+} TTSlot;
+
+
+/**
+* @struct TransTable
+* @brief The table; share one pointer between search threads.
+*/
+typedef struct {
+	TTSlot* slots; // buckets * TT_BUCKET_SLOTS slots
+	uint64_t mask; // buckets - 1
+	TTPolicy policy;
+	_Atomic unsigned generation; // Bumped by tt_new_generation()
+} TransTable;
+
+
+/**
+* @brief Allocate a table of at most bytes bytes (at least one bucket).
+* @return 0 on success, -1 if out of memory.
+*/
+int tt_init(TransTable* t, size_t bytes, TTPolicy policy);
+
+
+/**
+* @brief Look a key up.
+* @param depth Least depth the caller can use.
+* @param value Set to the stored value on a hit.
+* @return 1 on a hit, 0 if the key is missing or was searched shallower.
+*/
+int tt_probe(TransTable* t, uint64_t key, int depth, double* value);
+
+
+/**
+* @brief Record a search result; depth is clamped to TT_MAX_DEPTH.
+*/
+void tt_store(TransTable* t, uint64_t key, int depth, double value);
+
+
+/**
+* @brief Start a new search generation, so the depth policy lets earlier
+*        results be replaced. Call once per search, not per node.
+*/
+void tt_new_generation(TransTable* t);
+
+
+/**
+* @brief Empty every slot. Not safe while other threads use the table.
+*/
+void tt_clear(TransTable* t);
+
+
+/**
+* @brief Free a table's slots.
+*/
+void tt_free(TransTable* t);
+
+#endif
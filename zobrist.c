@@ -0,0 +1,63 @@
+#include "zobrist.h"
+
+/* splitmix64 outputs from seed 0x5A0B5A0B5A0B5A0B, one per card byte */
+const uint64_t zobrist_keys[64] = {
+    0x76DE5449DA57B9AFULL, 0x3430EBF580BF3626ULL, 0x39E2D9DD3CC2FFCFULL, 0x31075C50F8B52B22ULL,
+    0x9A906D1C582BB528ULL, 0x856FECFAEF314916ULL, 0x57CC3B0900F0B80CULL, 0xF3BD60C819D71B75ULL,
+    0x72A066F5FCD9CAD0ULL, 0x6F68C0A687D0F9F9ULL, 0x97C614864E8767DBULL, 0xFE82176F6DB031E9ULL,
+    0xD389F8414060E614ULL, 0xF5783914A957D197ULL, 0x40320BCDF08D7993ULL, 0x65CFD71C1D8A5504ULL,
+    0xF8FCDAE7919E2B59ULL, 0xA233A264AD4710B3ULL, 0x591E8956836B2CEEULL, 0x326E4003B98771A4ULL,
+    0x25B6FE472BA3B1FEULL, 0x5282BD7786D19D63ULL, 0xB188EBFAF7AA5968ULL, 0x913DC089ACB0EEABULL,
+    0xC69B20EB46319043ULL, 0x94D8192CE3A85E94ULL, 0x6C3F04CC01B32532ULL, 0xB9F70E0B301BB847ULL,
+    0xA162D8239230AC6CULL, 0x151F0B8836144C70ULL, 0xD587828F2636EB8EULL, 0x187649850D1D4ED9ULL,
+    0xB0E608D4B2199048ULL, 0x7A9936391A1CC344ULL, 0x6614ECF30BC22D4BULL, 0x545EEEE574AC335AULL,
+    0x06C0B1640EEFCA10ULL, 0x2E594D6A28674063ULL, 0x1506CF64362AF8C9ULL, 0x39C3E322AC02DAD0ULL,
+    0xEFF2990DD95CCA0CULL, 0xEC876BCDC5FB99E0ULL, 0x1CDA91AC3B7B34A3ULL, 0xC8FEAF61B827B96BULL,
+    0xD3E24D13AC96E7C2ULL, 0x6597936498F5304AULL, 0xB95FB2A5308372BEULL, 0x9A543BCD6BE63D76ULL,
+    0xF347D4909C8C44A5ULL, 0x5DD49686023A1829ULL, 0xE7B4201EB57A248BULL, 0xAFACA76FB2ACD490ULL,
+    0xDB1E884DA59C4B5BULL, 0x2A2CF2CCDA80F0B9ULL, 0x0DE50F29159EE0CDULL, 0x3036A2354210B9F7ULL,
+    0x0A4818F966136465ULL, 0x5FB2B1FABACC9353ULL, 0x4354105B277976E5ULL, 0x1FEAE3A0F032766AULL,
+    0x637F2EF977EE9E1EULL, 0x4391840A30B87763ULL, 0x3A4CBAC370F961C1ULL, 0xAF58B2F91762582DULL,
+};
+
+/* odd weights, so no zone's sum can stand in for another's */
+#define WEIGHT_HAND1 0x28E591FE7557FDFBULL
+#define WEIGHT_HAND2 0xA36108ACC7EFE171ULL
+#define WEIGHT_HIDDEN 0x84730B411AAE2369ULL
+#define WEIGHT_TOP 0x32063DDF9D147129ULL
+#define KEY_TURN2 0x64B86A94EC76EFA7ULL
+#define KEY_PASS 0xD6E8FEB86659FD93ULL
+
+/* Every card of packs packs in hidden */
+void zobrist_reset(Zobrist* z, int64_t packs)
+{
+    uint64_t pack = 0;
+    for (int s = CLUB; s <= DIAMOND; s++) {
+        for (int r = TWO; r <= ACE; r++)
+            pack += zobrist_keys[card_create((Suit)s, (Rank)r).bits];
+    }
+
+    z->sum[ZOBRIST_HAND1] = 0;
+    z->sum[ZOBRIST_HAND2] = 0;
+    z->sum[ZOBRIST_HIDDEN] = pack * (uint64_t)packs;
+    z->sum[ZOBRIST_PLAYED] = 0;
+}
+
+/* Weighted sums plus top, turn and passes, then a 64-bit finalizer
+ * (MurmurHash3's) so every output bit depends on every input bit */
+uint64_t zobrist_hash(const Zobrist* z, Card top, int turn, int passes)
+{
+    uint64_t h = z->sum[ZOBRIST_HAND1] * WEIGHT_HAND1
+        + z->sum[ZOBRIST_HAND2] * WEIGHT_HAND2
+        + z->sum[ZOBRIST_HIDDEN] * WEIGHT_HIDDEN
+        + zobrist_keys[top.bits] * WEIGHT_TOP
+        + (turn == 2 ? KEY_TURN2 : 0)
+        + (uint64_t)passes * KEY_PASS;
+
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
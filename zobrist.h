@@ -0,0 +1,111 @@
+/**
+* @file zobrist.h
+* @brief 64-bit position hashes kept up to date one card at a time.
+*
+* Every card has a fixed random 64-bit key. A position's identity is which
+* cards are in each hand and in the hidden pile, the face-up card, the
+* seat to move and how many turns in a row have passed (a second pass ends
+* the game); the cards under the top card follow from the rest, since
+* a game never gains or loses cards. The order of a pile or hand is not
+* part of it.
+*
+* Classic Zobrist hashing XORs the keys of the pieces present. With
+* several packs two copies of a card would cancel, so here each zone adds
+* its cards' keys instead (mod 2^64): a multiset of any size hashes in one
+* add per card, and moving a card is one subtract and one add. The cards
+* under the top card get a sum of their own, so a refill, which moves all
+* of them into the hidden pile at once, is one assignment.
+*
+* zobrist_hash() weights each zone's sum by its own odd constant, adds the
+* top card, the seat to move and the pass count and mixes the result.
+* Games (game.h) and GameStates (gameState.h) keep the same sums, so a
+* state captured from a game hashes to the same value as the game.
+*/
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <stdint.h>
+#include "Card.h"
+
+
+/**
+* @enum ZobristZone
+* @brief Places a card can be, each with its own running sum.
+*/
+typedef enum {
+	ZOBRIST_HAND1 = 0, // Player 1's hand; player p's is ZOBRIST_HAND1 + p - 1
+	ZOBRIST_HAND2, // Player 2's hand
+	ZOBRIST_HIDDEN, // Hidden pile (or shoe)
+	ZOBRIST_PLAYED, // Under the top card; not hashed, kept for refills
+	ZOBRIST_ZONES
+} ZobristZone;
+
+
+/**
+* @struct Zobrist
+* @brief Sum of card keys in each zone.
+*/
+typedef struct {
+	uint64_t sum[ZOBRIST_ZONES];
+} Zobrist;
+
+
+extern const uint64_t zobrist_keys[64]; // One key per packed card byte
+
+
+/**
+* @brief Put one copy of c in a zone.
+*/
+static inline void zobrist_add(Zobrist* z, int zone, Card c)
+{
+	z->sum[zone] += zobrist_keys[c.bits];
+}
+
+
+/**
+* @brief Take one copy of c out of a zone.
+*/
+static inline void zobrist_remove(Zobrist* z, int zone, Card c)
+{
+	z->sum[zone] -= zobrist_keys[c.bits];
+}
+
+
+/**
+* @brief Move one copy of c between zones.
+*/
+static inline void zobrist_move(Zobrist* z, int from, int to, Card c)
+{
+	uint64_t key = zobrist_keys[c.bits];
+	z->sum[from] -= key;
+	z->sum[to] += key;
+}
+
+
+/**
+* @brief Everything under the top card becomes the hidden pile, which must
+*        be empty.
+*/
+static inline void zobrist_refill(Zobrist* z)
+{
+	z->sum[ZOBRIST_HIDDEN] += z->sum[ZOBRIST_PLAYED];
+	z->sum[ZOBRIST_PLAYED] = 0;
+}
+
+
+/**
+* @brief Start with packs full packs in the hidden pile and nothing else.
+*/
+void zobrist_reset(Zobrist* z, int64_t packs);
+
+
+/**
+* @brief The position hash.
+* @param top Face-up card.
+* @param turn Seat to move, 1 or 2.
+* @param passes Consecutive turns with no play and no draw.
+*/
+uint64_t zobrist_hash(const Zobrist* z, Card top, int turn, int passes);
+
+
+#endif